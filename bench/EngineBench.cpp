@@ -0,0 +1,273 @@
+#include "../core/AllocationTracker.h"
+#include "../core/Profiler.h"
+#include "../renderer/OffscreenRenderer.h"
+#include "../resourceManager/Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Headless frame-time benchmark. Renders N frames of each scene into an
+// offscreen target and reports CPU/GPU frame-time percentiles as JSON.
+//
+//   engine_bench [--frames N] [--warmup N] [--entities 1000,100000]
+//                [--meshes N] [--resolution N] [--scene file]
+//                [--width W] [--height H] [--shaders dir] [--device name]
+//                [--output file.json] [--trace trace.json] [--validation]
+//                [--cpu-budget-mb N] [--gpu-budget-mb N] [--drop-cpu-after-upload]
+//                [--require-no-alloc]
+//
+// --require-no-alloc exits with code 3 if any measured frame allocated; it
+// needs a build with ENGINE_ALLOC_TRACKING=ON.
+
+namespace {
+
+struct BenchOptions {
+    uint32_t frames = 200;
+    uint32_t warmup = 10;
+    std::vector<uint32_t> entities{1000, 10000, 100000, 1000000};
+    uint32_t meshes = 64;
+    uint32_t resolution = 8;
+    std::string scenePath;
+    OffscreenConfig renderer;
+    CacheBudget budget;
+    std::string output;
+    std::string tracePath;
+    bool requireNoAlloc = false;
+};
+
+struct Percentiles {
+    double min = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0, mean = 0.0;
+};
+
+Percentiles computePercentiles(std::vector<double> samples) {
+    Percentiles result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        const auto index = static_cast<size_t>(q * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    result.min = samples.front();
+    result.p50 = at(0.50);
+    result.p90 = at(0.90);
+    result.p99 = at(0.99);
+    result.max = samples.back();
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    result.mean = sum / samples.size();
+    return result;
+}
+
+void writePercentiles(std::ostream &os, const Percentiles &p) {
+    os << "{\"min\": " << p.min << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+       << ", \"p99\": " << p.p99 << ", \"max\": " << p.max << ", \"mean\": " << p.mean << "}";
+}
+
+std::vector<uint32_t> parseList(const std::string &value) {
+    std::vector<uint32_t> result;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        result.push_back(static_cast<uint32_t>(std::stoul(item)));
+    }
+    return result;
+}
+
+BenchOptions parseOptions(int argc, char *argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--frames") options.frames = std::stoul(next());
+        else if (arg == "--warmup") options.warmup = std::stoul(next());
+        else if (arg == "--entities") options.entities = parseList(next());
+        else if (arg == "--meshes") options.meshes = std::stoul(next());
+        else if (arg == "--resolution") options.resolution = std::stoul(next());
+        else if (arg == "--scene") options.scenePath = next();
+        else if (arg == "--width") options.renderer.width = std::stoul(next());
+        else if (arg == "--height") options.renderer.height = std::stoul(next());
+        else if (arg == "--shaders") options.renderer.shaderDirectory = next();
+        else if (arg == "--device") options.renderer.preferredDevice = next();
+        else if (arg == "--output") options.output = next();
+        else if (arg == "--trace") options.tracePath = next();
+        else if (arg == "--validation") options.renderer.enableValidation = true;
+        else if (arg == "--cpu-budget-mb") options.budget.cpuBytes = std::stoull(next()) << 20;
+        else if (arg == "--gpu-budget-mb") options.budget.gpuBytes = std::stoull(next()) << 20;
+        else if (arg == "--drop-cpu-after-upload") options.budget.dropCpuAfterUpload = true;
+        else if (arg == "--require-no-alloc") options.requireNoAlloc = true;
+        else throw std::runtime_error("unknown argument " + arg);
+    }
+    return options;
+}
+
+struct RunResult {
+    std::string name;
+    uint32_t entities = 0;
+    uint32_t drawCalls = 0;
+    uint64_t triangles = 0;
+    Percentiles cpu;
+    Percentiles gpu;
+    bool gpuTimestamps = false;
+    CacheStats cache;
+    // Summed over the measured frames.
+    AllocationCounts allocations;
+    uint64_t maxFrameAllocations = 0;
+};
+
+RunResult runScene(const std::string &name, const SceneDescription &scene,
+                   const BenchOptions &options, std::string &deviceName) {
+    ResourceManager resourceManager(options.budget);
+    World world;
+    RunResult result;
+    result.name = name;
+    result.entities = buildScene(scene, resourceManager, world);
+
+    OffscreenRenderer renderer(&resourceManager, &world, options.renderer);
+    deviceName = renderer.deviceName();
+
+    for (uint32_t i = 0; i < options.warmup; i++) {
+        renderer.renderFrame();
+    }
+
+    std::vector<double> cpu, gpu;
+    cpu.reserve(options.frames);
+    gpu.reserve(options.frames);
+    for (uint32_t i = 0; i < options.frames; i++) {
+        const FrameTiming timing = renderer.renderFrame();
+        const AllocationCounts &allocations = renderer.core().lastFrameStats().allocations;
+        for (size_t s = 0; s < allocations.allocations.size(); s++) {
+            result.allocations.allocations[s] += allocations.allocations[s];
+        }
+        result.maxFrameAllocations = std::max(result.maxFrameAllocations, allocations.total());
+        cpu.push_back(timing.cpuMs);
+        if (timing.gpuMs >= 0.0) {
+            gpu.push_back(timing.gpuMs);
+        }
+    }
+
+    result.drawCalls = renderer.core().lastFrameStats().drawCalls;
+    result.triangles = renderer.core().lastFrameStats().triangles;
+    result.cpu = computePercentiles(cpu);
+    result.gpuTimestamps = !gpu.empty();
+    result.gpu = computePercentiles(gpu);
+    result.cache = resourceManager.stats();
+
+    std::cerr << "engine_bench: " << name << " cpu p50 " << result.cpu.p50 << " ms, gpu p50 "
+              << result.gpu.p50 << " ms" << std::endl;
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const BenchOptions options = parseOptions(argc, argv);
+        if (options.requireNoAlloc && !kAllocationTrackingEnabled) {
+            std::cerr << "engine_bench: --require-no-alloc needs a build with ENGINE_ALLOC_TRACKING=ON" << std::endl;
+            return 1;
+        }
+        std::vector<RunResult> results;
+        std::string deviceName;
+
+        if (!options.scenePath.empty()) {
+            results.push_back(runScene(options.scenePath, loadSceneDescription(options.scenePath),
+                                       options, deviceName));
+        }
+        else {
+            for (uint32_t entities : options.entities) {
+                SceneDescription scene;
+                scene.syntheticEntities = entities;
+                scene.syntheticMeshes = options.meshes;
+                scene.syntheticResolution = options.resolution;
+                results.push_back(runScene("synthetic_" + std::to_string(entities), scene, options, deviceName));
+            }
+        }
+
+        std::ostringstream json;
+        json << "{\n  \"device\": \"" << deviceName << "\",\n"
+             << "  \"width\": " << options.renderer.width << ",\n"
+             << "  \"height\": " << options.renderer.height << ",\n"
+             << "  \"frames\": " << options.frames << ",\n"
+             << "  \"runs\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto &r = results[i];
+            json << "    {\"name\": \"" << r.name << "\", \"entities\": " << r.entities
+                 << ", \"draw_calls\": " << r.drawCalls << ", \"triangles\": " << r.triangles
+                 << ",\n     \"cpu_ms\": ";
+            writePercentiles(json, r.cpu);
+            json << ",\n     \"gpu_ms\": ";
+            if (r.gpuTimestamps) {
+                writePercentiles(json, r.gpu);
+            }
+            else {
+                json << "null";
+            }
+            json << ",\n     \"cache\": {\"hits\": " << r.cache.hits << ", \"misses\": " << r.cache.misses
+                 << ", \"evictions\": " << r.cache.evictions << ", \"cpu_bytes\": " << r.cache.cpuBytesResident
+                 << ", \"gpu_bytes\": " << r.cache.gpuBytesResident
+                 << ", \"path_alias_hits\": " << r.cache.pathAliasHits
+                 << ", \"file_hash_hits\": " << r.cache.fileHashHits
+                 << ", \"geometry_hash_hits\": " << r.cache.geometryHashHits
+                 << ", \"bytes_deduplicated\": " << r.cache.bytesDeduplicated
+                 << ", \"textures_loaded\": " << r.cache.texturesLoaded
+                 << ", \"texture_cache_hits\": " << r.cache.textureCacheHits
+                 << ", \"texture_bytes\": " << r.cache.textureBytesResident << "}";
+            json << ",\n     \"allocations\": {\"max_per_frame\": " << r.maxFrameAllocations;
+            for (size_t s = 0; s < r.allocations.allocations.size(); s++) {
+                json << ", \"" << AllocationTracker::name(static_cast<Subsystem>(s)) << "\": "
+                     << r.allocations.allocations[s];
+            }
+            json << "}";
+            json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        json << "  ]\n}\n";
+
+        if (options.output.empty()) {
+            std::cout << json.str();
+        }
+        else {
+            std::ofstream(options.output) << json.str();
+        }
+
+        if (!options.tracePath.empty()) {
+            if (!kProfilingEnabled) {
+                std::cerr << "engine_bench: --trace needs a build with ENGINE_PROFILING=ON" << std::endl;
+            }
+            else if (!Profiler::writeChromeTrace(options.tracePath)) {
+                std::cerr << "engine_bench: failed to write " << options.tracePath << std::endl;
+            }
+        }
+
+        if (options.requireNoAlloc) {
+            bool allocated = false;
+            for (const auto &r : results) {
+                if (r.maxFrameAllocations > 0) {
+                    std::cerr << "engine_bench: " << r.name << " allocated up to " << r.maxFrameAllocations
+                              << " times per frame" << std::endl;
+                    allocated = true;
+                }
+            }
+            if (allocated) {
+                return 3;
+            }
+        }
+    }
+    catch (const std::exception &e) {
+        std::cerr << "engine_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
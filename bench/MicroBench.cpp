@@ -0,0 +1,531 @@
+#include "../core/JobSystem.h"
+#include "../renderer/OffscreenRenderer.h"
+#include "../resourceManager/ObjParser.h"
+#include "../resourceManager/Scene.h"
+#include "../resourceManager/Simulation.h"
+#include "../resourceManager/WorldSnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for engine hot paths.
+//
+//   engine_microbench [--output results.json] [--filter substring]
+//                     [--assets dir] [--obj-sizes 256,1024] [--min-time seconds]
+//                     [--job-threads 1,2,4,8]
+//                     [--gpu [--shaders dir] [--device name]]
+//                     [--compare baseline.json [--threshold 0.10]]
+//
+// Results are written as JSON, one benchmark per line. With --compare, every
+// benchmark slower than the baseline by more than the threshold is reported
+// and the exit code is 2.
+
+namespace {
+
+volatile uint64_t g_sink = 0;
+
+template <typename T>
+void consume(const T &value) {
+    g_sink = g_sink + static_cast<uint64_t>(value);
+}
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;
+    double nsPerOp = 0.0;
+    double itemsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+};
+
+class MicroBench {
+public:
+    MicroBench(std::string filter, double minTime) : m_filter(std::move(filter)), m_minTime(minTime) {}
+
+    // Runs fn in batches until minTime elapses and reports the median batch.
+    // itemsPerOp/bytesPerOp turn the timing into throughput.
+    void run(const std::string &name, const std::function<void()> &fn,
+             double itemsPerOp = 0.0, double bytesPerOp = 0.0) {
+        if (!m_filter.empty() && name.find(m_filter) == std::string::npos) {
+            return;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        fn();
+
+        uint64_t batch = 1;
+        std::vector<double> samples;
+        uint64_t iterations = 0;
+        const auto start = Clock::now();
+        while (std::chrono::duration<double>(Clock::now() - start).count() < m_minTime || samples.size() < 3) {
+            const auto batchStart = Clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                fn();
+            }
+            const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - batchStart).count();
+            samples.push_back(elapsed / batch);
+            iterations += batch;
+            if (elapsed < 1e6 && batch < (1u << 20)) {
+                batch *= 2;
+            }
+        }
+
+        std::sort(samples.begin(), samples.end());
+        BenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.nsPerOp = samples[samples.size() / 2];
+        result.itemsPerSecond = itemsPerOp * 1e9 / result.nsPerOp;
+        result.bytesPerSecond = bytesPerOp * 1e9 / result.nsPerOp;
+        m_results.push_back(result);
+
+        std::cerr << name << ": " << result.nsPerOp << " ns/op";
+        if (bytesPerOp > 0.0) {
+            std::cerr << ", " << result.bytesPerSecond / (1024.0 * 1024.0) << " MB/s";
+        }
+        else if (itemsPerOp > 0.0) {
+            std::cerr << ", " << result.itemsPerSecond << " items/s";
+        }
+        std::cerr << std::endl;
+    }
+
+    const std::vector<BenchResult> &results() const { return m_results; }
+
+private:
+    std::string m_filter;
+    double m_minTime;
+    std::vector<BenchResult> m_results;
+};
+
+struct Options {
+    std::string output = "engine_microbench.json";
+    std::string filter;
+    std::string assets = ".";
+    std::vector<uint32_t> objSizes{256, 1024};
+    // Empty: powers of two up to the core count, and the core count.
+    std::vector<uint32_t> jobThreads;
+    double minTime = 0.5;
+    bool gpu = false;
+    OffscreenConfig renderer;
+    std::string baseline;
+    double threshold = 0.10;
+};
+
+std::vector<uint32_t> parseList(const std::string &value) {
+    std::vector<uint32_t> result;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        result.push_back(static_cast<uint32_t>(std::stoul(item)));
+    }
+    return result;
+}
+
+Options parseOptions(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--output") options.output = next();
+        else if (arg == "--filter") options.filter = next();
+        else if (arg == "--assets") options.assets = next();
+        else if (arg == "--obj-sizes") options.objSizes = parseList(next());
+        else if (arg == "--job-threads") options.jobThreads = parseList(next());
+        else if (arg == "--min-time") options.minTime = std::stod(next());
+        else if (arg == "--gpu") options.gpu = true;
+        else if (arg == "--shaders") options.renderer.shaderDirectory = next();
+        else if (arg == "--device") options.renderer.preferredDevice = next();
+        else if (arg == "--compare") options.baseline = next();
+        else if (arg == "--threshold") options.threshold = std::stod(next());
+        else throw std::runtime_error("unknown argument " + arg);
+    }
+    return options;
+}
+
+// Writes a (size x size) textured grid as OBJ, returns the path.
+std::string writeGridObj(uint32_t size) {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("sge_microbench_grid_" + std::to_string(size) + ".obj");
+    if (std::filesystem::exists(path)) {
+        return path.string();
+    }
+    std::ofstream file(path);
+    const uint32_t side = size + 1;
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            file << "v " << x * 0.01f << " " << y * 0.01f << " " << std::sin(x * 0.1f) * 0.05f << "\n";
+        }
+    }
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            file << "vt " << static_cast<float>(x) / size << " " << static_cast<float>(y) / size << "\n";
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const uint32_t i = y * side + x + 1;
+            file << "f " << i << "/" << i << " " << i + side << "/" << i + side << " " << i + 1 << "/" << i + 1 << "\n";
+            file << "f " << i + 1 << "/" << i + 1 << " " << i + side << "/" << i + side << " "
+                 << i + side + 1 << "/" << i + side + 1 << "\n";
+        }
+    }
+    return path.string();
+}
+
+std::vector<std::pair<std::string, std::string>> objFiles(const Options &options) {
+    std::vector<std::pair<std::string, std::string>> files;
+    for (const char *asset : {"cube.obj", "cottage_obj.obj"}) {
+        const auto path = std::filesystem::path(options.assets) / asset;
+        if (std::filesystem::exists(path)) {
+            files.emplace_back(asset, path.string());
+        }
+        else {
+            std::cerr << "skipping " << asset << ": not found in " << options.assets << std::endl;
+        }
+    }
+    for (uint32_t size : options.objSizes) {
+        files.emplace_back("grid_" + std::to_string(size), writeGridObj(size));
+    }
+    return files;
+}
+
+void benchLoadMesh(MicroBench &bench, const Options &options) {
+    for (const auto &[name, path] : objFiles(options)) {
+        const double bytes = static_cast<double>(std::filesystem::file_size(path));
+        bench.run("loadMesh/" + name, [&path]() {
+            ResourceManager resourceManager;
+            auto mesh = resourceManager.getMesh(path);
+            consume(mesh ? mesh->indices.size() : 0);
+        }, 0.0, bytes);
+    }
+}
+
+// Parser throughput in MB/s, without the cache around it.
+void benchObjParsers(MicroBench &bench, const Options &options) {
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (const auto &[name, path] : objFiles(options)) {
+        const double bytes = static_cast<double>(std::filesystem::file_size(path));
+        bench.run("objparse/tinyobj/" + name, [&path]() {
+            auto mesh = loadObjTinyObj(path);
+            consume(mesh ? mesh->indices.size() : 0);
+        }, 0.0, bytes);
+        bench.run("objparse/native_1t/" + name, [&path]() {
+            auto mesh = parseObjParallel(path, 1);
+            consume(mesh ? mesh->indices.size() : 0);
+        }, 0.0, bytes);
+        bench.run("objparse/native_mt/" + name, [&path, threads]() {
+            auto mesh = parseObjParallel(path, threads);
+            consume(mesh ? mesh->indices.size() : 0);
+        }, 0.0, bytes);
+    }
+}
+
+void benchDeduplication(MicroBench &bench) {
+    for (uint32_t size : {64u, 512u}) {
+        // Expand the grid to one vertex per index, as the loader sees it.
+        auto grid = generateGridMesh(size, {1.0f, 1.0f, 1.0f});
+        std::vector<Node> expanded;
+        expanded.reserve(grid->indices.size());
+        for (uint32_t index : grid->indices) {
+            expanded.push_back(grid->nodes[index]);
+        }
+        bench.run("dedup/grid_" + std::to_string(size), [&expanded]() {
+            Mesh mesh;
+            NodeDeduplicator deduplicator(mesh);
+            for (const Node &node : expanded) {
+                deduplicator.add(node);
+            }
+            consume(mesh.nodes.size());
+        }, static_cast<double>(expanded.size()));
+        bench.run("dedup/grid_" + std::to_string(size) + "_position", [&expanded]() {
+            std::vector<PositionVertex> vertices;
+            std::vector<uint32_t> indices;
+            VertexDeduplicator<PositionVertex> deduplicator(vertices, indices);
+            for (const Node &node : expanded) {
+                deduplicator.add(convertVertex<PositionVertex>(node));
+            }
+            consume(vertices.size());
+        }, static_cast<double>(expanded.size()));
+    }
+}
+
+void benchWorld(MicroBench &bench) {
+    auto mesh = generateGridMesh(1, {1.0f, 1.0f, 1.0f});
+    for (uint32_t count : {1000u, 100000u, 1000000u}) {
+        const std::string suffix = "/" + std::to_string(count);
+
+        bench.run("world/createEntity" + suffix, [count]() {
+            World world;
+            for (uint32_t i = 0; i < count; i++) {
+                consume(world.createEntity());
+            }
+        }, count);
+
+        bench.run("world/addComponent" + suffix, [count, &mesh]() {
+            World world;
+            for (uint32_t i = 0; i < count; i++) {
+                const Entity id = world.createEntity();
+                world.addComponent(id, RenderElement(mesh));
+                world.addComponent(id, TransformElement());
+            }
+        }, count);
+
+        World world;
+        for (uint32_t i = 0; i < count; i++) {
+            const Entity id = world.createEntity();
+            world.addComponent(id, RenderElement(mesh));
+            world.addComponent(id, TransformElement());
+        }
+
+        bench.run("world/getComponent" + suffix, [count, &world]() {
+            uint64_t hits = 0;
+            for (Entity e = 0; e < count; e++) {
+                hits += world.getComponent(e).hasTransformElement();
+            }
+            consume(hits);
+        }, count);
+
+        bench.run("world/iterate" + suffix, [&world]() {
+            float sum = 0.0f;
+            for (Entity e : world.getAllEntities()) {
+                if (!world.entityHasComponent<RenderElement>(e) ||
+                    !world.entityHasComponent<TransformElement>(e)) {
+                    continue;
+                }
+                sum += world.getComponent(e).transform->position.x;
+            }
+            consume(sum);
+        }, count);
+
+        Simulation simulation(&world);
+        bench.run("world/simulationTick" + suffix, [&simulation]() {
+            simulation.step();
+            consume(simulation.acquireSnapshot().instances.size());
+        }, count);
+
+        const std::string snapshot =
+            (std::filesystem::temp_directory_path() / ("engine_microbench_world" + suffix.substr(1) + ".bin")).string();
+        bench.run("world/snapshotSave" + suffix, [&world, &snapshot]() {
+            saveWorldSnapshot(world, snapshot);
+        }, count);
+
+        ResourceManager resourceManager;
+        bench.run("world/snapshotLoad" + suffix, [&snapshot, &resourceManager]() {
+            World loaded;
+            loadWorldSnapshot(snapshot, loaded, resourceManager);
+            consume(loaded.getAllEntities().size());
+        }, count);
+        std::filesystem::remove(snapshot);
+    }
+}
+
+void benchTransforms(MicroBench &bench) {
+    const uint32_t count = 100000;
+    std::vector<TransformElement> transforms(count);
+    for (uint32_t i = 0; i < count; i++) {
+        transforms[i].position = {i * 0.1f, i * 0.2f, i * 0.3f};
+        transforms[i].rotation = {i * 0.01f, i * 0.02f, i * 0.03f};
+    }
+    std::vector<glm::mat4> matrices(count);
+    bench.run("transform/modelMatrix", [&]() {
+        for (uint32_t i = 0; i < count; i++) {
+            matrices[i] = transforms[i].modelMatrix();
+        }
+        consume(matrices[count / 2][3][0]);
+    }, count);
+}
+
+void benchGpu(MicroBench &bench, const Options &options) {
+    ResourceManager resourceManager;
+    World world;
+    OffscreenRenderer renderer(&resourceManager, &world, options.renderer);
+    RenderCore &core = renderer.core();
+    const VkDevice device = core.context().device;
+    std::cerr << "gpu benchmarks on " << renderer.deviceName() << std::endl;
+
+    for (VkDeviceSize size : {VkDeviceSize(64 * 1024), VkDeviceSize(16 * 1024 * 1024)}) {
+        bench.run("gpu/createBuffer/" + std::to_string(size / 1024) + "KB", [&]() {
+            VkBuffer buffer;
+            VkDeviceMemory memory;
+            core.createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
+    }
+
+    for (uint32_t size : {64u, 512u}) {
+        auto mesh = generateGridMesh(size, {1.0f, 1.0f, 1.0f});
+        const double bytes = static_cast<double>(mesh->nodes.size() * sizeof(Node) +
+                                                 mesh->indices.size() * sizeof(uint32_t));
+        bench.run("gpu/createMeshBuffers/grid_" + std::to_string(size), [&]() {
+            core.createMeshBuffers(*mesh);
+            core.destroyMeshBuffers(*mesh);
+        }, 0.0, bytes);
+    }
+}
+
+void writeResults(const std::string &path, const std::vector<BenchResult> &results) {
+    std::ofstream file(path);
+    file << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        file << "  {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+             << ", \"ns_per_op\": " << r.nsPerOp << ", \"items_per_second\": " << r.itemsPerSecond
+             << ", \"bytes_per_second\": " << r.bytesPerSecond << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "]}\n";
+}
+
+// Reads back the name/ns_per_op pairs of a file written by writeResults.
+std::map<std::string, double> readBaseline(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open baseline " + path);
+    }
+    const std::regex entry("\"name\": \"([^\"]+)\".*\"ns_per_op\": ([0-9.eE+-]+)");
+    std::map<std::string, double> baseline;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::smatch match;
+        if (std::regex_search(line, match, entry)) {
+            baseline[match[1]] = std::stod(match[2]);
+        }
+    }
+    return baseline;
+}
+
+int compareWithBaseline(const std::vector<BenchResult> &results, const Options &options) {
+    const auto baseline = readBaseline(options.baseline);
+    int regressions = 0;
+    for (const auto &r : results) {
+        const auto it = baseline.find(r.name);
+        if (it == baseline.end()) {
+            std::cerr << "  new        " << r.name << std::endl;
+            continue;
+        }
+        const double change = r.nsPerOp / it->second - 1.0;
+        const bool regressed = change > options.threshold;
+        regressions += regressed;
+        std::cerr << (regressed ? "  REGRESSED  " : "  ok         ") << r.name << " "
+                  << (change >= 0 ? "+" : "") << change * 100.0 << "%" << std::endl;
+    }
+    std::cerr << regressions << " regression(s) above " << options.threshold * 100.0 << "%" << std::endl;
+    return regressions ? 2 : 0;
+}
+
+// Job system scaling: the same work on 1..N threads, so items/s against the
+// thread count shows how far each pattern scales.
+void benchJobs(MicroBench &bench, const Options &options) {
+    std::vector<uint32_t> threadCounts = options.jobThreads;
+    if (threadCounts.empty()) {
+        const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t threads = 1; threads < cores; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(cores);
+    }
+
+    const uint32_t count = 1000000;
+    std::vector<TransformElement> transforms(count);
+    for (uint32_t i = 0; i < count; i++) {
+        transforms[i].position = {i * 0.1f, i * 0.2f, i * 0.3f};
+        transforms[i].rotation = {i * 0.01f, i * 0.02f, i * 0.03f};
+    }
+    std::vector<glm::mat4> matrices(count);
+
+    for (uint32_t threads : threadCounts) {
+        JobSystem jobs(std::max(threads, 1u) - 1);
+        const std::string suffix = "/" + std::to_string(jobs.threadCount());
+
+        bench.run("jobs/parallelFor" + suffix, [&]() {
+            jobs.parallelFor(0, count, 4096, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    matrices[i] = transforms[i].modelMatrix();
+                }
+            });
+            consume(matrices[count / 2][3][0]);
+        }, count);
+
+        // Scheduling overhead: jobs that do almost nothing.
+        const uint32_t spawnCount = 100000;
+        bench.run("jobs/spawn" + suffix, [&]() {
+            std::atomic<uint64_t> sum{0};
+            JobCounter counter;
+            for (uint32_t i = 0; i < spawnCount; i++) {
+                jobs.run([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+            }
+            jobs.wait(counter);
+            consume(sum.load());
+        }, spawnCount);
+
+        // Stages that depend on the previous one, as in load -> update -> cull.
+        const uint32_t stages = 16, jobsPerStage = 64, itemsPerJob = count / (stages * jobsPerStage);
+        bench.run("jobs/graph" + suffix, [&]() {
+            std::vector<JobCounter> counters(stages);
+            for (uint32_t stage = 0; stage < stages; stage++) {
+                for (uint32_t job = 0; job < jobsPerStage; job++) {
+                    const size_t begin = (size_t(stage) * jobsPerStage + job) * itemsPerJob;
+                    auto work = [&, begin] {
+                        for (size_t i = begin; i < begin + itemsPerJob; i++) {
+                            matrices[i] = transforms[i].modelMatrix();
+                        }
+                    };
+                    if (stage == 0) {
+                        jobs.run(work, &counters[stage]);
+                    }
+                    else {
+                        jobs.runAfter(counters[stage - 1], work, &counters[stage]);
+                    }
+                }
+            }
+            jobs.wait(counters.back());
+            consume(matrices[0][3][0]);
+        }, stages * jobsPerStage * itemsPerJob);
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        MicroBench bench(options.filter, options.minTime);
+
+        benchLoadMesh(bench, options);
+        benchObjParsers(bench, options);
+        benchDeduplication(bench);
+        benchWorld(bench);
+        benchTransforms(bench);
+        benchJobs(bench, options);
+        if (options.gpu) {
+            benchGpu(bench, options);
+        }
+
+        writeResults(options.output, bench.results());
+        if (!options.baseline.empty()) {
+            return compareWithBaseline(bench.results(), options);
+        }
+    }
+    catch (const std::exception &e) {
+        std::cerr << "engine_microbench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
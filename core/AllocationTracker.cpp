@@ -0,0 +1,143 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+constexpr size_t kSubsystemCount = static_cast<size_t>(Subsystem::Count);
+
+// Trivially constructible, so usable by allocations made before main().
+std::atomic<uint64_t> g_counts[kSubsystemCount];
+thread_local Subsystem t_subsystem = Subsystem::Other;
+
+}
+
+uint64_t AllocationCounts::total() const {
+    uint64_t sum = 0;
+    for (uint64_t count : allocations) {
+        sum += count;
+    }
+    return sum;
+}
+
+AllocationCounts AllocationCounts::operator-(const AllocationCounts &earlier) const {
+    AllocationCounts result;
+    for (size_t i = 0; i < kSubsystemCount; i++) {
+        result.allocations[i] = allocations[i] - earlier.allocations[i];
+    }
+    return result;
+}
+
+AllocationCounts AllocationTracker::counts() {
+    AllocationCounts result;
+    for (size_t i = 0; i < kSubsystemCount; i++) {
+        result.allocations[i] = g_counts[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+const char *AllocationTracker::name(Subsystem subsystem) {
+    switch (subsystem) {
+    case Subsystem::Renderer: return "renderer";
+    case Subsystem::Resources: return "resources";
+    case Subsystem::Simulation: return "simulation";
+    case Subsystem::Jobs: return "jobs";
+    default: return "other";
+    }
+}
+
+Subsystem AllocationTracker::current() {
+    return t_subsystem;
+}
+
+void AllocationTracker::setCurrent(Subsystem subsystem) {
+    t_subsystem = subsystem;
+}
+
+#ifdef SGE_ALLOC_TRACKING
+
+namespace {
+
+void *allocate(size_t size, size_t alignment) {
+    g_counts[static_cast<size_t>(t_subsystem)].fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void release(void *data, size_t alignment) {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(data);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(data);
+}
+
+void *allocateOrThrow(size_t size, size_t alignment) {
+    if (void *data = allocate(size, alignment)) {
+        return data;
+    }
+    throw std::bad_alloc();
+}
+
+constexpr size_t kDefault = alignof(std::max_align_t);
+
+}
+
+void *operator new(size_t size) { return allocateOrThrow(size, kDefault); }
+void *operator new[](size_t size) { return allocateOrThrow(size, kDefault); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return allocate(size, kDefault); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return allocate(size, kDefault); }
+void *operator new(size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *data) noexcept { release(data, kDefault); }
+void operator delete[](void *data) noexcept { release(data, kDefault); }
+void operator delete(void *data, size_t) noexcept { release(data, kDefault); }
+void operator delete[](void *data, size_t) noexcept { release(data, kDefault); }
+void operator delete(void *data, const std::nothrow_t &) noexcept { release(data, kDefault); }
+void operator delete[](void *data, const std::nothrow_t &) noexcept { release(data, kDefault); }
+void operator delete(void *data, std::align_val_t alignment) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+void operator delete[](void *data, std::align_val_t alignment) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+void operator delete(void *data, size_t, std::align_val_t alignment) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+void operator delete[](void *data, size_t, std::align_val_t alignment) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+void operator delete(void *data, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+void operator delete[](void *data, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    release(data, static_cast<size_t>(alignment));
+}
+
+#endif // SGE_ALLOC_TRACKING
@@ -0,0 +1,72 @@
+#ifndef ALLOCATION_TRACKER
+#define ALLOCATION_TRACKER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Counts heap allocations by subsystem. Enabled with
+// -DENGINE_ALLOC_TRACKING=ON, which replaces the global operator new; without
+// it every count stays zero and ALLOC_SCOPE expands to nothing.
+//
+// Each thread carries a current subsystem, set by ALLOC_SCOPE. Jobs run
+// under the subsystem of the thread that submitted them, so a parallelFor
+// started by the renderer counts as Renderer on every worker.
+
+#ifdef SGE_ALLOC_TRACKING
+inline constexpr bool kAllocationTrackingEnabled = true;
+#else
+inline constexpr bool kAllocationTrackingEnabled = false;
+#endif
+
+enum class Subsystem : uint8_t {
+    Other,
+    Renderer,
+    Resources,
+    Simulation,
+    Jobs,
+    Count,
+};
+
+struct AllocationCounts {
+    std::array<uint64_t, static_cast<size_t>(Subsystem::Count)> allocations{};
+
+    uint64_t operator[](Subsystem subsystem) const {
+        return allocations[static_cast<size_t>(subsystem)];
+    }
+    uint64_t total() const;
+    AllocationCounts operator-(const AllocationCounts &earlier) const;
+};
+
+class AllocationTracker {
+public:
+    // Allocations since the process started.
+    static AllocationCounts counts();
+    static const char *name(Subsystem subsystem);
+
+    static Subsystem current();
+    static void setCurrent(Subsystem subsystem);
+
+    class Scope {
+    public:
+        explicit Scope(Subsystem subsystem) : m_previous(current()) { setCurrent(subsystem); }
+        ~Scope() { setCurrent(m_previous); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Subsystem m_previous;
+    };
+};
+
+#ifdef SGE_ALLOC_TRACKING
+#define SGE_ALLOC_CONCAT_INNER(a, b) a##b
+#define SGE_ALLOC_CONCAT(a, b) SGE_ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_SCOPE(subsystem) \
+    AllocationTracker::Scope SGE_ALLOC_CONCAT(allocationScope, __LINE__)(subsystem)
+#else
+#define ALLOC_SCOPE(subsystem) ((void)0)
+#endif
+
+#endif // ALLOCATION_TRACKER
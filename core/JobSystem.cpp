@@ -0,0 +1,191 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <string>
+
+namespace {
+
+thread_local const JobSystem *t_system = nullptr;
+thread_local unsigned t_worker = 0;
+
+}
+
+JobSystem::JobSystem(unsigned workers) {
+    for (unsigned i = 0; i <= workers; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    m_workers.reserve(workers);
+    for (unsigned i = 0; i < workers; i++) {
+        m_workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+JobSystem &JobSystem::global() {
+    static JobSystem system(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return system;
+}
+
+void JobSystem::run(std::function<void()> fn, JobCounter *counter) {
+    if (counter) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    push({std::move(fn), counter, AllocationTracker::current()}, false);
+}
+
+void JobSystem::runAfter(JobCounter &dependency, std::function<void()> fn, JobCounter *counter) {
+    if (counter) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (dependency.m_pending.load(std::memory_order_acquire) != 0) {
+            dependency.m_continuations.push_back({this, std::move(fn), counter, AllocationTracker::current()});
+            return;
+        }
+    }
+    push({std::move(fn), counter, AllocationTracker::current()}, false);
+}
+
+void JobSystem::runBackground(std::function<void()> fn, JobCounter *counter) {
+    if (counter) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    Job job{std::move(fn), counter, AllocationTracker::current()};
+    if (m_workers.empty()) {
+        execute(job);
+        return;
+    }
+    push(std::move(job), true);
+}
+
+void JobSystem::wait(JobCounter &counter) {
+    Job job;
+    while (!counter.done()) {
+        if (take(job, false)) {
+            execute(job);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    t_system = this;
+    t_worker = index;
+    PROFILE_THREAD("job worker " + std::to_string(index));
+    AllocationTracker::setCurrent(Subsystem::Jobs);
+    Job job;
+    while (true) {
+        if (take(job, true)) {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+        if (m_stop && m_queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void JobSystem::push(Job &&job, bool background) {
+    Queue &queue = background ? m_background : *m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        pushBack(queue, std::move(job));
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+    // Taking the lock orders this against a worker that is about to sleep.
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_wake.notify_one();
+}
+
+bool JobSystem::take(Job &job, bool background) {
+    if (m_queued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    const size_t own = currentQueue();
+    if (popBack(*m_queues[own], job)) {
+        return true;
+    }
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        if (popFront(*m_queues[(own + i) % m_queues.size()], job)) {
+            return true;
+        }
+    }
+    return background && popFront(m_background, job);
+}
+
+void JobSystem::pushBack(Queue &queue, Job &&job) {
+    if (queue.count == queue.slots.size()) {
+        std::vector<Job> slots(queue.slots.size() * 2);
+        for (size_t i = 0; i < queue.count; i++) {
+            slots[i] = std::move(queue.slots[(queue.head + i) % queue.slots.size()]);
+        }
+        queue.slots = std::move(slots);
+        queue.head = 0;
+    }
+    queue.slots[(queue.head + queue.count) % queue.slots.size()] = std::move(job);
+    queue.count++;
+}
+
+bool JobSystem::popBack(Queue &queue, Job &job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.count == 0) {
+        return false;
+    }
+    queue.count--;
+    job = std::move(queue.slots[(queue.head + queue.count) % queue.slots.size()]);
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::popFront(Queue &queue, Job &job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.count == 0) {
+        return false;
+    }
+    job = std::move(queue.slots[queue.head]);
+    queue.head = (queue.head + 1) % queue.slots.size();
+    queue.count--;
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void JobSystem::execute(Job &job) {
+    AllocationTracker::Scope scope(job.subsystem);
+    job.fn();
+    job.fn = nullptr;
+    if (job.counter) {
+        finish(*job.counter);
+    }
+}
+
+void JobSystem::finish(JobCounter &counter) {
+    std::vector<JobCounter::Continuation> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+        if (counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready.swap(counter.m_continuations);
+        }
+    }
+    for (auto &continuation : ready) {
+        continuation.system->push({std::move(continuation.fn), continuation.counter, continuation.subsystem},
+                                  false);
+    }
+}
+
+unsigned JobSystem::currentQueue() const {
+    return t_system == this ? t_worker : static_cast<unsigned>(m_queues.size() - 1);
+}
@@ -0,0 +1,154 @@
+#ifndef JOB_SYSTEM
+#define JOB_SYSTEM
+
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing job scheduler. Every worker owns a deque: it pushes and pops
+// its own jobs at the back and steals from the front of the others. Threads
+// that are not workers (the GUI thread) submit through a shared queue and
+// help execute jobs while they wait, so a parallelFor on the render thread
+// also uses the render thread.
+//
+// Background jobs (file loads, reparses) sit in a separate FIFO that only
+// idle workers take: a thread waiting on a counter never picks one up, so a
+// frame cannot stall on somebody else's I/O.
+//
+// Jobs must not throw. Submitting does not allocate once the queues have
+// grown to the working set, as long as the callable fits std::function's
+// inline buffer (two pointers with libstdc++); parallelFor's jobs do.
+
+class JobSystem;
+
+// Counts unfinished jobs. Jobs submitted with runAfter() start once their
+// dependency counter drops to zero. Must outlive the jobs that signal it.
+class JobCounter {
+public:
+    JobCounter() = default;
+    // Waits out a finishing job that still holds m_mutex.
+    ~JobCounter() { std::lock_guard<std::mutex> lock(m_mutex); }
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation {
+        JobSystem *system;
+        std::function<void()> fn;
+        JobCounter *counter;
+        Subsystem subsystem;
+    };
+
+    std::atomic<uint32_t> m_pending{0};
+    std::mutex m_mutex;
+    std::vector<Continuation> m_continuations;
+};
+
+class JobSystem {
+public:
+    // Starts `workers` threads; the thread that waits is the extra one. With
+    // zero workers, background jobs run inline when they are submitted.
+    explicit JobSystem(unsigned workers);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Shared instance with a worker for every core but the calling one.
+    static JobSystem &global();
+
+    unsigned workerCount() const { return static_cast<unsigned>(m_workers.size()); }
+    // Workers plus the waiting thread.
+    unsigned threadCount() const { return workerCount() + 1; }
+
+    void run(std::function<void()> fn, JobCounter *counter = nullptr);
+    void runAfter(JobCounter &dependency, std::function<void()> fn, JobCounter *counter = nullptr);
+    void runBackground(std::function<void()> fn, JobCounter *counter = nullptr);
+
+    // Runs other jobs until `counter` is done.
+    void wait(JobCounter &counter);
+
+    // Calls fn(rangeBegin, rangeEnd) over [begin, end) split into ranges of at
+    // least `grain` items, and returns when all of them are done.
+    template <typename Fn>
+    void parallelFor(size_t begin, size_t end, size_t grain, Fn &&fn) {
+        if (begin >= end) {
+            return;
+        }
+        const size_t count = end - begin;
+        grain = std::max<size_t>(grain, 1);
+        // A few ranges per thread even out uneven work through stealing.
+        const size_t ranges = std::min((count + grain - 1) / grain, size_t(threadCount()) * 4);
+        if (ranges <= 1) {
+            fn(begin, end);
+            return;
+        }
+        const size_t step = (count + ranges - 1) / ranges;
+        // Jobs capture this and an index only, which keeps them allocation-free.
+        struct Split {
+            std::remove_reference_t<Fn> *fn;
+            size_t begin, end, step;
+        } split{&fn, begin, end, step};
+        JobCounter counter;
+        for (size_t index = 1; begin + index * step < end; index++) {
+            run([&split, index] {
+                const size_t rangeBegin = split.begin + index * split.step;
+                (*split.fn)(rangeBegin, std::min(rangeBegin + split.step, split.end));
+            }, &counter);
+        }
+        fn(begin, begin + step);
+        wait(counter);
+    }
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        JobCounter *counter = nullptr;
+        // Allocations made by the job count against its submitter.
+        Subsystem subsystem = Subsystem::Other;
+    };
+
+    // Ring buffer that grows when full; unlike std::deque it never frees and
+    // reallocates blocks as it drains and refills.
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Job> slots = std::vector<Job>(256);
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    void workerLoop(unsigned index);
+    void push(Job &&job, bool background);
+    bool take(Job &job, bool background);
+    void pushBack(Queue &queue, Job &&job);
+    bool popBack(Queue &queue, Job &job);
+    bool popFront(Queue &queue, Job &job);
+    void execute(Job &job);
+    void finish(JobCounter &counter);
+    unsigned currentQueue() const;
+
+    std::vector<std::thread> m_workers;
+    // One per worker, then the queue shared by outside threads.
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    Queue m_background;
+
+    std::atomic<size_t> m_queued{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+};
+
+#endif // JOB_SYSTEM
@@ -0,0 +1,61 @@
+#include "LinearArena.h"
+
+namespace {
+
+constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+
+}
+
+LinearArena::LinearArena(size_t capacity, std::pmr::memory_resource *upstream)
+    : m_upstream(upstream), m_capacity(capacity) {
+    if (m_capacity > 0) {
+        m_block = static_cast<std::byte *>(m_upstream->allocate(m_capacity, kBlockAlignment));
+    }
+}
+
+LinearArena::~LinearArena() {
+    releaseOverflow();
+    if (m_block) {
+        m_upstream->deallocate(m_block, m_capacity, kBlockAlignment);
+    }
+}
+
+void LinearArena::reset() {
+    const size_t highWater = used();
+    releaseOverflow();
+    if (highWater > m_capacity) {
+        // Room for the whole last round plus some slack for alignment.
+        const size_t capacity = highWater + highWater / 4;
+        if (m_block) {
+            m_upstream->deallocate(m_block, m_capacity, kBlockAlignment);
+        }
+        m_block = static_cast<std::byte *>(m_upstream->allocate(capacity, kBlockAlignment));
+        m_capacity = capacity;
+    }
+    m_offset = 0;
+}
+
+void *LinearArena::do_allocate(size_t bytes, size_t alignment) {
+    if (m_block) {
+        const auto base = reinterpret_cast<uintptr_t>(m_block);
+        const uintptr_t aligned = (base + m_offset + alignment - 1) & ~uintptr_t(alignment - 1);
+        const size_t end = aligned - base + bytes;
+        if (end <= m_capacity) {
+            m_offset = end;
+            return reinterpret_cast<void *>(aligned);
+        }
+    }
+    void *data = m_upstream->allocate(bytes, alignment);
+    m_overflow.push_back({data, bytes, alignment});
+    m_overflowBytes += bytes;
+    m_overflowCount++;
+    return data;
+}
+
+void LinearArena::releaseOverflow() {
+    for (const Overflow &overflow : m_overflow) {
+        m_upstream->deallocate(overflow.data, overflow.bytes, overflow.alignment);
+    }
+    m_overflow.clear();
+    m_overflowBytes = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef LINEAR_ARENA
+#define LINEAR_ARENA
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that dies together: everything a frame or a load
+// allocates. deallocate() is a no-op and reset() frees everything at once, so
+// pmr containers built on it cost a pointer bump per allocation.
+//
+// When the block runs out, allocations fall back to upstream overflow blocks;
+// the next reset() frees those and grows the block to the high-water mark, so
+// a steady workload settles on one block and stops touching the heap.
+//
+// Not thread-safe: one arena per thread or per task.
+class LinearArena : public std::pmr::memory_resource {
+public:
+    explicit LinearArena(size_t capacity = 0,
+                         std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    ~LinearArena() override;
+
+    LinearArena(const LinearArena &) = delete;
+    LinearArena &operator=(const LinearArena &) = delete;
+
+    // Invalidates everything allocated since the last reset.
+    void reset();
+
+    // Bytes handed out since the last reset, overflow included.
+    size_t used() const { return m_offset + m_overflowBytes; }
+    size_t capacity() const { return m_capacity; }
+    // Allocations that missed the block since construction.
+    uint64_t overflowCount() const { return m_overflowCount; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Overflow {
+        void *data;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    void releaseOverflow();
+
+    std::pmr::memory_resource *m_upstream;
+    std::byte *m_block = nullptr;
+    size_t m_capacity = 0;
+    size_t m_offset = 0;
+    std::vector<Overflow> m_overflow;
+    size_t m_overflowBytes = 0;
+    uint64_t m_overflowCount = 0;
+};
+
+#endif // LINEAR_ARENA
@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Empty files are open with size() == 0 and no data().
+    bool isOpen() const { return m_open; }
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    void close();
+
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+};
+
+#endif // MAPPED_FILE
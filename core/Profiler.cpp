@@ -0,0 +1,102 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct ProfilerRegistry {
+    std::mutex mutex;
+    // Buffers are never freed so events of finished threads can still be exported.
+    std::vector<std::unique_ptr<ProfileThreadBuffer>> buffers;
+};
+
+ProfilerRegistry &registry() {
+    static ProfilerRegistry instance;
+    return instance;
+}
+
+void writeEscaped(std::ostream &os, const std::string &text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+}
+
+}
+
+ProfileThreadBuffer &Profiler::registerThread() {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto buffer = std::make_unique<ProfileThreadBuffer>();
+    buffer->threadIndex = static_cast<uint32_t>(reg.buffers.size());
+    buffer->threadName = "thread " + std::to_string(buffer->threadIndex);
+    reg.buffers.push_back(std::move(buffer));
+    return *reg.buffers.back();
+}
+
+void Profiler::setThreadName(const std::string &name) {
+    auto &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.threadName = name;
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // CPU threads live in pid 1, GPU queue zones in pid 2.
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"CPU\"}},\n";
+    file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"GPU\"}}";
+
+    uint64_t dropped = 0;
+    for (const auto &buffer : reg.buffers) {
+        file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadIndex
+             << ", \"args\": {\"name\": \"";
+        writeEscaped(file, buffer->threadName);
+        file << "\"}}";
+
+        // Copy the ring, then skip whatever the owner overwrote meanwhile; the
+        // slot after `end` may be mid-write, so it is dropped as well.
+        const uint64_t end = buffer->count.load(std::memory_order_acquire);
+        const uint64_t begin = end > ProfileThreadBuffer::kCapacity ? end - ProfileThreadBuffer::kCapacity : 0;
+        std::vector<ProfileEvent> events;
+        events.reserve(end - begin);
+        for (uint64_t i = begin; i < end; i++) {
+            events.push_back(buffer->events[i % ProfileThreadBuffer::kCapacity]);
+        }
+        const uint64_t written = buffer->count.load(std::memory_order_acquire) + 1;
+        const uint64_t firstIntact =
+            std::max(begin, written > ProfileThreadBuffer::kCapacity ? written - ProfileThreadBuffer::kCapacity : 0);
+        dropped += std::min(firstIntact, end);
+
+        for (uint64_t i = firstIntact; i < end; i++) {
+            const ProfileEvent &event = events[i - begin];
+            file << ",\n{\"name\": \"";
+            writeEscaped(file, event.name);
+            file << "\", \"ph\": \"X\", \"pid\": " << (event.gpu ? 2 : 1)
+                 << ", \"tid\": " << (event.gpu ? 0 : buffer->threadIndex)
+                 << ", \"ts\": " << event.startNs / 1000.0
+                 << ", \"dur\": " << (event.endNs - event.startNs) / 1000.0 << "}";
+        }
+    }
+    file << "\n], \"otherData\": {\"droppedEvents\": " << dropped << "}}\n";
+    return file.good();
+}
+
+void Profiler::reset() {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto &buffer : reg.buffers) {
+        buffer->count.store(0, std::memory_order_release);
+    }
+}
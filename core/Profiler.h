@@ -0,0 +1,115 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Scoped CPU zones and GPU zone sink, exported as Chrome trace JSON (loads in
+// chrome://tracing and ui.perfetto.dev). Enabled with -DENGINE_PROFILING=ON;
+// otherwise the PROFILE_* macros expand to nothing.
+//
+// Zone names must outlive the profiler (string literals, __func__).
+
+#ifdef SGE_PROFILING
+inline constexpr bool kProfilingEnabled = true;
+#else
+inline constexpr bool kProfilingEnabled = false;
+#endif
+
+struct ProfileEvent {
+    const char *name = nullptr;
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+    bool gpu = false;
+};
+
+// Events of one thread, a ring that keeps the newest kCapacity events so a
+// long session still exports its last seconds. Only the owning thread writes;
+// `count` is the number of events ever pushed and is published after the slot
+// is written, so recording takes no locks.
+struct ProfileThreadBuffer {
+    static constexpr size_t kCapacity = 1 << 16;
+
+    std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[kCapacity]};
+    std::atomic<uint64_t> count{0};
+    uint32_t threadIndex = 0;
+    std::string threadName;
+
+    void push(const ProfileEvent &event) {
+        const uint64_t index = count.load(std::memory_order_relaxed);
+        events[index % kCapacity] = event;
+        count.store(index + 1, std::memory_order_release);
+    }
+};
+
+class Profiler {
+public:
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - s_epoch).count());
+    }
+
+    static void record(const char *name, uint64_t startNs, uint64_t endNs) {
+        threadBuffer().push({name, startNs, endNs, false});
+    }
+
+    // GPU zones are already converted to the CPU timeline by the caller.
+    static void recordGpu(const char *name, uint64_t startNs, uint64_t endNs) {
+        threadBuffer().push({name, startNs, endNs, true});
+    }
+
+    static void setThreadName(const std::string &name);
+
+    // Writes the events still held by each thread's ring; older ones are
+    // counted as "droppedEvents" in the trace metadata. Safe to call while
+    // other threads record; events published after the call starts may be
+    // missed, and ones overwritten while being copied are dropped.
+    static bool writeChromeTrace(const std::string &path);
+
+    // Drops recorded events. Must not race with recording threads.
+    static void reset();
+
+    class Zone {
+    public:
+        explicit Zone(const char *name) : m_name(name), m_start(nowNs()) {}
+        ~Zone() { record(m_name, m_start, nowNs()); }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *m_name;
+        uint64_t m_start;
+    };
+
+private:
+    static ProfileThreadBuffer &registerThread();
+
+    static ProfileThreadBuffer &threadBuffer() {
+        if (!s_threadBuffer) {
+            s_threadBuffer = &registerThread();
+        }
+        return *s_threadBuffer;
+    }
+
+    static inline const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+    static inline thread_local ProfileThreadBuffer *s_threadBuffer = nullptr;
+};
+
+#define SGE_PROFILE_CONCAT_INNER(a, b) a##b
+#define SGE_PROFILE_CONCAT(a, b) SGE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef SGE_PROFILING
+#define PROFILE_SCOPE(name) Profiler::Zone SGE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif // PROFILER
@@ -0,0 +1,204 @@
+#include "Stats.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+enum class StatKind {
+    Counter,
+    Gauge,
+    Histogram,
+};
+
+struct StatEntry {
+    StatKind kind;
+    // Only the one matching `kind` is set. Never freed, so references handed
+    // out stay valid for the life of the process.
+    std::unique_ptr<StatCounter> counter;
+    std::unique_ptr<StatGauge> gauge;
+    std::unique_ptr<StatHistogram> histogram;
+};
+
+struct StatsRegistry {
+    std::mutex mutex;
+    std::map<std::string, StatEntry> entries;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+StatsRegistry &registry() {
+    static StatsRegistry instance;
+    return instance;
+}
+
+StatEntry &entry(const std::string &name, StatKind kind) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto [it, inserted] = reg.entries.try_emplace(name);
+    StatEntry &stat = it->second;
+    if (inserted) {
+        stat.kind = kind;
+        switch (kind) {
+        case StatKind::Counter: stat.counter = std::make_unique<StatCounter>(); break;
+        case StatKind::Gauge: stat.gauge = std::make_unique<StatGauge>(); break;
+        case StatKind::Histogram: stat.histogram = std::make_unique<StatHistogram>(); break;
+        }
+    }
+    else if (stat.kind != kind) {
+        throw std::logic_error("Stats: \"" + name + "\" is registered as another kind of stat");
+    }
+    return stat;
+}
+
+void writeEscaped(std::ostream &os, const std::string &text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+}
+
+}
+
+size_t StatHistogram::bucketOf(uint64_t value) {
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    // The top bit selects the power of two, the bits below it the sub-bucket.
+    const int exponent = std::bit_width(value) - 1;
+    const int shift = exponent - kSubBucketBits;
+    return kSubBuckets * static_cast<size_t>(shift + 1) + ((value >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t StatHistogram::bucketLower(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    const size_t shift = bucket / kSubBuckets - 1;
+    return (kSubBuckets + bucket % kSubBuckets) << shift;
+}
+
+uint64_t StatHistogram::bucketUpper(size_t bucket) {
+    if (bucket + 1 >= kBuckets) {
+        return UINT64_MAX;
+    }
+    return bucketLower(bucket + 1) - 1;
+}
+
+void StatHistogram::record(uint64_t value) {
+    m_buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot StatHistogram::snapshot() const {
+    HistogramSnapshot result;
+    // The count is summed from the buckets so percentile() always adds up.
+    for (size_t i = 0; i < kBuckets; i++) {
+        result.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        result.count += result.buckets[i];
+    }
+    result.sum = m_sum.load(std::memory_order_relaxed);
+    result.max = m_max.load(std::memory_order_relaxed);
+    return result;
+}
+
+uint64_t HistogramSnapshot::percentile(double fraction) const {
+    if (!count) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            const uint64_t lower = StatHistogram::bucketLower(i);
+            const uint64_t middle = lower + (StatHistogram::bucketUpper(i) - lower) / 2;
+            return std::min(middle, max);
+        }
+    }
+    return max;
+}
+
+HistogramSnapshot HistogramSnapshot::operator-(const HistogramSnapshot &earlier) const {
+    HistogramSnapshot result;
+    for (size_t i = 0; i < kBuckets; i++) {
+        result.buckets[i] = buckets[i] - earlier.buckets[i];
+        result.count += result.buckets[i];
+        if (result.buckets[i]) {
+            result.max = std::min(max, StatHistogram::bucketUpper(i));
+        }
+    }
+    result.sum = sum - earlier.sum;
+    return result;
+}
+
+StatCounter &Stats::counter(const std::string &name) {
+    return *entry(name, StatKind::Counter).counter;
+}
+
+StatGauge &Stats::gauge(const std::string &name) {
+    return *entry(name, StatKind::Gauge).gauge;
+}
+
+StatHistogram &Stats::histogram(const std::string &name) {
+    return *entry(name, StatKind::Histogram).histogram;
+}
+
+StatsSnapshot Stats::snapshot() {
+    auto &reg = registry();
+    StatsSnapshot result;
+    result.uptimeSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - reg.start).count();
+
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &[name, stat] : reg.entries) {
+        switch (stat.kind) {
+        case StatKind::Counter: result.counters.emplace_back(name, stat.counter->value()); break;
+        case StatKind::Gauge: result.gauges.emplace_back(name, stat.gauge->value()); break;
+        case StatKind::Histogram: result.histograms.emplace_back(name, stat.histogram->snapshot()); break;
+        }
+    }
+    return result;
+}
+
+std::string StatsSnapshot::toJson() const {
+    std::ostringstream json;
+    json << "{\"uptime_s\": " << uptimeSeconds << ",\n \"counters\": {";
+    const char *separator = "";
+    for (const auto &[name, value] : counters) {
+        json << separator << "\"";
+        writeEscaped(json, name);
+        json << "\": " << value;
+        separator = ", ";
+    }
+    json << "},\n \"gauges\": {";
+    separator = "";
+    for (const auto &[name, value] : gauges) {
+        json << separator << "\"";
+        writeEscaped(json, name);
+        json << "\": " << value;
+        separator = ", ";
+    }
+    json << "},\n \"histograms\": {";
+    separator = "\n  ";
+    for (const auto &[name, histogram] : histograms) {
+        json << separator << "\"";
+        writeEscaped(json, name);
+        json << "\": {\"count\": " << histogram.count << ", \"sum\": " << histogram.sum
+             << ", \"mean\": " << histogram.mean() << ", \"max\": " << histogram.max
+             << ", \"p50\": " << histogram.percentile(0.5) << ", \"p90\": " << histogram.percentile(0.9)
+             << ", \"p99\": " << histogram.percentile(0.99) << "}";
+        separator = ",\n  ";
+    }
+    json << "}}\n";
+    return json.str();
+}
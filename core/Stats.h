@@ -0,0 +1,105 @@
+#ifndef STATS
+#define STATS
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Named runtime statistics for live monitoring: counters, gauges and
+// histograms that any thread updates with relaxed atomics and no locks.
+// Stats::counter() and friends register a name on first use and return the
+// same object afterwards, so hot paths look a stat up once and keep the
+// reference. Registration takes a lock and allocates; updates never do.
+//
+// Names are dotted and carry their unit: "render.frame_time_us".
+
+// Only ever grows.
+class StatCounter {
+public:
+    void add(uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+// The latest value of something, e.g. draw calls of the last frame.
+class StatGauge {
+public:
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(int64_t amount) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+struct HistogramSnapshot {
+    // 16 buckets per power of two, exact below 16.
+    static constexpr int kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets * (64 - kSubBucketBits + 1);
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::array<uint64_t, kBuckets> buckets{};
+
+    // Value below which `fraction` of the samples lie, to within the bucket
+    // width (1/16 of the value). Zero without samples.
+    uint64_t percentile(double fraction) const;
+    double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+    // Samples recorded between `earlier` and this snapshot. `max` becomes the
+    // top of the highest bucket that gained samples.
+    HistogramSnapshot operator-(const HistogramSnapshot &earlier) const;
+};
+
+// Distribution of non-negative integer samples in log-linear buckets. Memory
+// is fixed (8 KB); recording is a few relaxed atomic adds.
+class StatHistogram {
+public:
+    static constexpr int kSubBucketBits = HistogramSnapshot::kSubBucketBits;
+    static constexpr size_t kSubBuckets = HistogramSnapshot::kSubBuckets;
+    static constexpr size_t kBuckets = HistogramSnapshot::kBuckets;
+
+    void record(uint64_t value);
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketLower(size_t bucket);
+    static uint64_t bucketUpper(size_t bucket);
+
+private:
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+    std::array<std::atomic<uint64_t>, kBuckets> m_buckets{};
+};
+
+// Every registered stat at one point in time, sorted by name.
+struct StatsSnapshot {
+    double uptimeSeconds = 0.0;
+    std::vector<std::pair<std::string, uint64_t>> counters;
+    std::vector<std::pair<std::string, int64_t>> gauges;
+    std::vector<std::pair<std::string, HistogramSnapshot>> histograms;
+
+    // {"uptime_s":..., "counters":{...}, "gauges":{...},
+    //  "histograms":{"name":{"count","sum","mean","max","p50","p90","p99"}}}
+    std::string toJson() const;
+};
+
+class Stats {
+public:
+    // A name belongs to one kind of stat; asking for it as another throws.
+    static StatCounter &counter(const std::string &name);
+    static StatGauge &gauge(const std::string &name);
+    static StatHistogram &histogram(const std::string &name);
+
+    // Safe to call while other threads update; each value is read once, so
+    // related stats may be a few updates apart.
+    static StatsSnapshot snapshot();
+};
+
+#endif // STATS
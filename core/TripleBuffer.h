@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER
+#define TRIPLE_BUFFER
+
+#include <atomic>
+#include <cstdint>
+
+// Hands values from one writer thread to one reader thread without either
+// waiting. The writer fills back() and publish()es it; the reader's acquire()
+// returns the newest published value and keeps returning it until a newer one
+// arrives. Three slots: one owned by each side and one in flight, swapped with
+// a single atomic exchange. Slots are reused, so values that keep their
+// capacity (vectors) stop allocating after the first few rounds.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side.
+    T &back() { return m_slots[m_back]; }
+
+    void publish() {
+        m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader side. Default-constructed until the first publish().
+    const T &acquire() {
+        if (m_middle.load(std::memory_order_relaxed) & kFresh) {
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndexMask;
+        }
+        return m_slots[m_front];
+    }
+
+    // The value the last acquire() returned.
+    const T &front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    T m_slots[3];
+    uint8_t m_back = 0;
+    uint8_t m_front = 1;
+    std::atomic<uint8_t> m_middle{2};
+};
+
+#endif // TRIPLE_BUFFER
@@ -1,39 +1,147 @@
 #include <QApplication>
 #include <QVulkanInstance>
 #include <QDebug>
+#include <cstring>
+#include "core/Profiler.h"
 #include "resourceManager/Component.h"
+#include "resourceManager/Scene.h"
+#include "resourceManager/Simulation.h"
+#include "resourceManager/WorldSnapshot.h"
+#include "renderer/OffscreenRenderer.h"
 #include "ui/MainWindow.h"
 #include "ui/QVulkanMainWindow.h"
+#include "ui/StatsServer.h"
 
+// Usage: engine_main [mesh.obj [--stream] | --scene file | --snapshot file] [--save-snapshot file]
+//                    [--trace trace.json] [--hot-reload] [--simulate [--tick-rate N]]
+//                    [--texture-cache dir] [--compress-textures]
+//                    [--stats] [--stats-port N] [--stats-socket name]
+//                    [--headless [--frames N] [--image out.ppm]]
 int main(int argc, char* argv[]) {
-    QApplication app(argc, argv);
+    SceneDescription scene;
+    scene.meshes.push_back({"cube.obj", 1});
+    bool headless = false;
+    uint32_t frames = 1;
+    std::string imagePath;
+    std::string tracePath;
+    bool hotReload = false;
+    bool stream = false;
+    std::string snapshotPath;
+    std::string saveSnapshotPath;
+    bool simulate = false;
+    double tickRate = 60.0;
+    TextureOptions textureOptions;
+    bool showStats = false;
+    quint16 statsPort = 0;
+    QString statsSocket;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--headless")) headless = true;
+        else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--image") && i + 1 < argc) imagePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--hot-reload")) hotReload = true;
+        else if (!std::strcmp(argv[i], "--stream")) stream = true;
+        else if (!std::strcmp(argv[i], "--simulate")) simulate = true;
+        else if (!std::strcmp(argv[i], "--tick-rate") && i + 1 < argc) tickRate = std::stod(argv[++i]);
+        else if (!std::strcmp(argv[i], "--scene") && i + 1 < argc) scene = loadSceneDescription(argv[++i]);
+        else if (!std::strcmp(argv[i], "--snapshot") && i + 1 < argc) snapshotPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--save-snapshot") && i + 1 < argc) saveSnapshotPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--texture-cache") && i + 1 < argc) textureOptions.cacheDirectory = argv[++i];
+        else if (!std::strcmp(argv[i], "--compress-textures")) textureOptions.compress = true;
+        else if (!std::strcmp(argv[i], "--stats")) showStats = true;
+        else if (!std::strcmp(argv[i], "--stats-port") && i + 1 < argc) statsPort = static_cast<quint16>(std::stoul(argv[++i]));
+        else if (!std::strcmp(argv[i], "--stats-socket") && i + 1 < argc) statsSocket = argv[++i];
+        else if (argv[i][0] != '-') scene.meshes = {{argv[i], 1}};
+    }
 
+    if (stream) {
+        for (auto &entry : scene.meshes) {
+            entry.stream = true;
+        }
+    }
+
+    PROFILE_THREAD("main");
     auto resourceManager = std::make_unique<ResourceManager>();
-    resourceManager->getMesh("D:\\documents\\PersonalHell\\repos\\SimpleGraphicsEngine1\\cube.obj");
-    auto mesh = resourceManager->getMesh("D:\\documents\\PersonalHell\\repos\\SimpleGraphicsEngine1\\cube.obj");
     auto world = std::make_unique<World>();
+    resourceManager->setHotReload(hotReload);
+    resourceManager->setTextureOptions(textureOptions);
+    if (snapshotPath.empty()) {
+        buildScene(scene, *resourceManager, *world);
+    }
+    else {
+        loadWorldSnapshot(snapshotPath, *world, *resourceManager);
+    }
+    if (!saveSnapshotPath.empty()) {
+        saveWorldSnapshot(*world, saveSnapshotPath);
+    }
+
+    // Demo logic for the simulation thread: every entity spins about Y.
+    std::unique_ptr<Simulation> simulation;
+    if (simulate) {
+        simulation = std::make_unique<Simulation>(world.get(), tickRate);
+        simulation->setUpdate([](World &simulated, double dt) {
+            for (auto &transform : simulated.storage<TransformElement>().components()) {
+                transform.rotation.y += static_cast<float>(dt);
+            }
+        });
+    }
+
+    if (headless) {
+        OffscreenRenderer renderer(resourceManager.get(), world.get());
+        if (simulation) {
+            renderer.core().setSimulation(simulation.get());
+            // Publish a snapshot before the first frame is drawn.
+            simulation->step();
+            simulation->start();
+        }
+        for (uint32_t i = 0; i < frames; i++) {
+            const FrameTiming timing = renderer.renderFrame();
+            qDebug() << "frame" << i << "cpu" << timing.cpuMs << "ms gpu" << timing.gpuMs << "ms";
+        }
+        if (!imagePath.empty()) {
+            renderer.saveImage(imagePath);
+        }
+        if (!tracePath.empty()) {
+            Profiler::writeChromeTrace(tracePath);
+        }
+        return 0;
+    }
+
+    QApplication app(argc, argv);
     auto instance = std::make_unique<QVulkanInstance>();
     
     if (!instance->create()) {
         qFatal("Failed to create Vulkan instance");
     }
 
-    auto vulkanWindow = new QVulkanMainWindow(nullptr, resourceManager.get(), world.get());
+    auto vulkanWindow = new QVulkanMainWindow(nullptr, resourceManager.get(), world.get(), simulation.release());
     vulkanWindow->setVulkanInstance(instance.get());
     
-    MainWindow mainWindow(vulkanWindow);
+    MainWindow mainWindow(vulkanWindow, showStats);
     mainWindow.show();
+
+    StatsServer statsServer;
+    if (statsPort) {
+        statsServer.listenTcp(statsPort);
+    }
+    if (!statsSocket.isEmpty()) {
+        statsServer.listenLocal(statsSocket);
+    }
     
     vulkanWindow->setProperty("m_resourceManager", QVariant::fromValue(resourceManager.release()));
     vulkanWindow->setProperty("m_world", QVariant::fromValue(world.release()));
     vulkanWindow->setProperty("vulkanInstance", QVariant::fromValue(instance.release()));
     
-    world->addComponent(RenderElement(mesh));
-    world->addComponent(0, TransformElement());
+    if (!tracePath.empty()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [&tracePath]() {
+            Profiler::writeChromeTrace(tracePath);
+        });
+    }
+
     try{
         return app.exec();
     }catch(...) {
         throw;
     }
    
-}
\ No newline at end of file
+}
@@ -0,0 +1,159 @@
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+void GpuProfiler::init(VkPhysicalDevice physicalDevice, VkDevice device,
+                       uint32_t queueFamilyIndex, uint32_t framesInFlight) {
+  if constexpr (!kProfilingEnabled) {
+    return;
+  }
+
+  uint32_t familyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> families(familyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount,
+                                           families.data());
+  if (queueFamilyIndex >= familyCount ||
+      families[queueFamilyIndex].timestampValidBits == 0) {
+    return;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  m_timestampPeriod = properties.limits.timestampPeriod;
+  m_device = device;
+  m_framesInFlight = std::max(framesInFlight, 1u);
+  // One slot per frame in flight plus one for immediate submits.
+  m_slots.assign(m_framesInFlight + 1, Slot{});
+
+  VkQueryPoolCreateInfo queryInfo{};
+  queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryInfo.queryCount =
+      static_cast<uint32_t>(m_slots.size()) * kMaxZonesPerSlot * 2;
+  if (vkCreateQueryPool(m_device, &queryInfo, nullptr, &m_queryPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "GpuProfiler::init(): Failed to create timestamp query pool.");
+  }
+}
+
+void GpuProfiler::release() {
+  if (m_queryPool) {
+    vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+    m_queryPool = VK_NULL_HANDLE;
+  }
+  m_slots.clear();
+}
+
+void GpuProfiler::resetSlot(VkCommandBuffer cmdBuf, uint32_t slotIndex) {
+  Slot &slot = m_slots[slotIndex];
+  slot.zones.clear();
+  slot.openZones.clear();
+  slot.usedQueries = 0;
+  slot.pending = true;
+  vkCmdResetQueryPool(cmdBuf, m_queryPool, slotIndex * kMaxZonesPerSlot * 2,
+                      kMaxZonesPerSlot * 2);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmdBuf) {
+  if (!active()) {
+    return;
+  }
+  const auto slotIndex = static_cast<uint32_t>(m_frameIndex++ % m_framesInFlight);
+  // The window waited on this slot's fence before handing us the frame, so
+  // its previous results are available.
+  collect(slotIndex, false);
+  resetSlot(cmdBuf, slotIndex);
+  m_slots[slotIndex].anchorNs = Profiler::nowNs();
+  m_recordingSlot = slotIndex;
+}
+
+void GpuProfiler::beginImmediate(VkCommandBuffer cmdBuf) {
+  if (!active()) {
+    return;
+  }
+  m_previousSlot = m_recordingSlot;
+  m_recordingSlot = m_framesInFlight;
+  resetSlot(cmdBuf, m_recordingSlot);
+}
+
+void GpuProfiler::endImmediate() {
+  if (!active()) {
+    return;
+  }
+  m_slots[m_framesInFlight].anchorNs = Profiler::nowNs();
+  collect(m_framesInFlight, true);
+  m_recordingSlot = m_previousSlot;
+}
+
+void GpuProfiler::beginZone(VkCommandBuffer cmdBuf, const char *name) {
+  if (!active()) {
+    return;
+  }
+  Slot &slot = m_slots[m_recordingSlot];
+  if (slot.usedQueries + 2 > kMaxZonesPerSlot * 2) {
+    return;
+  }
+  const uint32_t base = m_recordingSlot * kMaxZonesPerSlot * 2;
+  const uint32_t query = base + slot.usedQueries;
+  slot.usedQueries += 2;
+  vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool,
+                      query);
+  slot.openZones.push_back(static_cast<uint32_t>(slot.zones.size()));
+  slot.zones.push_back({name, query, query + 1});
+}
+
+void GpuProfiler::endZone(VkCommandBuffer cmdBuf) {
+  if (!active()) {
+    return;
+  }
+  Slot &slot = m_slots[m_recordingSlot];
+  if (slot.openZones.empty()) {
+    return;
+  }
+  const Zone &zone = slot.zones[slot.openZones.back()];
+  slot.openZones.pop_back();
+  vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      m_queryPool, zone.endQuery);
+}
+
+void GpuProfiler::collect(uint32_t slotIndex, bool anchorAtEnd) {
+  Slot &slot = m_slots[slotIndex];
+  if (!slot.pending || slot.usedQueries == 0) {
+    slot.pending = false;
+    return;
+  }
+  slot.pending = false;
+
+  const uint32_t base = slotIndex * kMaxZonesPerSlot * 2;
+  uint64_t timestamps[kMaxZonesPerSlot * 2] = {};
+  if (vkGetQueryPoolResults(m_device, m_queryPool, base, slot.usedQueries,
+                            sizeof(timestamps), timestamps, sizeof(uint64_t),
+                            VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+    return;
+  }
+
+  uint64_t first = UINT64_MAX;
+  uint64_t last = 0;
+  for (const Zone &zone : slot.zones) {
+    first = std::min(first, timestamps[zone.beginQuery - base]);
+    last = std::max(last, timestamps[zone.endQuery - base]);
+  }
+  auto toNs = [&](uint64_t ticks) {
+    return static_cast<uint64_t>(static_cast<double>(ticks) * m_timestampPeriod);
+  };
+  const uint64_t span = toNs(last - first);
+  const uint64_t origin =
+      anchorAtEnd && slot.anchorNs > span ? slot.anchorNs - span : slot.anchorNs;
+
+  for (const Zone &zone : slot.zones) {
+    const uint64_t begin = timestamps[zone.beginQuery - base];
+    const uint64_t end = timestamps[zone.endQuery - base];
+    if (end < begin) {
+      continue;
+    }
+    Profiler::recordGpu(zone.name, origin + toNs(begin - first),
+                        origin + toNs(end - first));
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef GPU_PROFILER
+#define GPU_PROFILER
+
+#include "../core/Profiler.h"
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// Timestamp-query zones on the graphics queue, forwarded to Profiler once the
+// command buffer that recorded them has retired. Every call is a no-op unless
+// the build has ENGINE_PROFILING enabled and the queue supports timestamps.
+//
+// GPU and CPU clocks are not calibrated: frame zones are anchored to the CPU
+// time the frame was recorded, immediate zones to the time their wait returned.
+class GpuProfiler {
+public:
+  static constexpr uint32_t kMaxZonesPerSlot = 32;
+
+  void init(VkPhysicalDevice physicalDevice, VkDevice device,
+            uint32_t queueFamilyIndex, uint32_t framesInFlight);
+  void release();
+
+  // Must be recorded outside a render pass. Forwards the zones recorded the
+  // last time this frame slot was used, then resets its queries.
+  void beginFrame(VkCommandBuffer cmdBuf);
+
+  // For one-shot command buffers the caller waits on (uploads). Zones go to a
+  // dedicated slot until endImmediate() reads them back.
+  void beginImmediate(VkCommandBuffer cmdBuf);
+  void endImmediate();
+
+  void beginZone(VkCommandBuffer cmdBuf, const char *name);
+  void endZone(VkCommandBuffer cmdBuf);
+
+  bool active() const {
+    return kProfilingEnabled && m_queryPool != VK_NULL_HANDLE;
+  }
+
+private:
+  struct Zone {
+    const char *name;
+    uint32_t beginQuery;
+    uint32_t endQuery;
+  };
+
+  struct Slot {
+    std::vector<Zone> zones;
+    std::vector<uint32_t> openZones;
+    uint32_t usedQueries = 0;
+    uint64_t anchorNs = 0;
+    bool pending = false;
+  };
+
+  void resetSlot(VkCommandBuffer cmdBuf, uint32_t slotIndex);
+  void collect(uint32_t slotIndex, bool anchorAtEnd);
+
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkQueryPool m_queryPool = VK_NULL_HANDLE;
+  double m_timestampPeriod = 0.0;
+  std::vector<Slot> m_slots;
+  uint32_t m_framesInFlight = 0;
+  uint64_t m_frameIndex = 0;
+  uint32_t m_recordingSlot = 0;
+  uint32_t m_previousSlot = 0;
+};
+
+#endif // GPU_PROFILER
@@ -0,0 +1,455 @@
+#include "OffscreenRenderer.h"
+#include "../core/Profiler.h"
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+OffscreenRenderer::OffscreenRenderer(ResourceManager *resourceManager,
+                                     World *world,
+                                     const OffscreenConfig &config)
+    : m_config(config), m_core(resourceManager, world) {
+  m_core.setShaderDirectory(m_config.shaderDirectory);
+
+  createInstance();
+  pickPhysicalDevice();
+  createDevice();
+  createRenderPass();
+
+  VulkanContext context{};
+  context.physicalDevice = m_physicalDevice;
+  context.device = m_device;
+  context.graphicsQueue = m_queue;
+  context.graphicsQueueFamilyIndex = m_queueFamilyIndex;
+  context.textureCompressionBC = m_textureCompressionBC;
+  context.sampledImageArrayDynamicIndexing = m_dynamicIndexing;
+  m_core.initResources(context, m_renderPass);
+
+  createTargets();
+  createCommandResources();
+  createQueryPool();
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+  if (m_device) {
+    vkDeviceWaitIdle(m_device);
+  }
+  m_core.releaseResources();
+
+  if (m_queryPool) vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+  if (m_fence) vkDestroyFence(m_device, m_fence, nullptr);
+  if (m_commandPool) vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+  if (m_framebuffer) vkDestroyFramebuffer(m_device, m_framebuffer, nullptr);
+  if (m_renderPass) vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+  if (m_depthView) vkDestroyImageView(m_device, m_depthView, nullptr);
+  if (m_depthImage) vkDestroyImage(m_device, m_depthImage, nullptr);
+  if (m_depthMemory) vkFreeMemory(m_device, m_depthMemory, nullptr);
+  if (m_colorView) vkDestroyImageView(m_device, m_colorView, nullptr);
+  if (m_colorImage) vkDestroyImage(m_device, m_colorImage, nullptr);
+  if (m_colorMemory) vkFreeMemory(m_device, m_colorMemory, nullptr);
+  if (m_device) vkDestroyDevice(m_device, nullptr);
+  if (m_instance) vkDestroyInstance(m_instance, nullptr);
+}
+
+void OffscreenRenderer::createInstance() {
+  VkApplicationInfo appInfo{};
+  appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  appInfo.pApplicationName = "SimpleGraphicsEngine";
+  appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+  appInfo.pEngineName = "SimpleGraphicsEngine";
+  appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+  appInfo.apiVersion = VK_API_VERSION_1_1;
+
+  const char *validationLayer = "VK_LAYER_KHRONOS_validation";
+
+  VkInstanceCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  createInfo.pApplicationInfo = &appInfo;
+  if (m_config.enableValidation) {
+    createInfo.enabledLayerCount = 1;
+    createInfo.ppEnabledLayerNames = &validationLayer;
+  }
+
+  if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS) {
+    throw std::runtime_error(
+        "OffscreenRenderer::createInstance(): Failed to create instance.");
+  }
+}
+
+void OffscreenRenderer::pickPhysicalDevice() {
+  uint32_t deviceCount = 0;
+  vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+  if (deviceCount == 0) {
+    throw std::runtime_error(
+        "OffscreenRenderer::pickPhysicalDevice(): No Vulkan devices found.");
+  }
+  std::vector<VkPhysicalDevice> devices(deviceCount);
+  vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+  for (VkPhysicalDevice device : devices) {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount,
+                                             families.data());
+
+    for (uint32_t i = 0; i < familyCount; i++) {
+      if (!(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+        continue;
+      }
+      VkPhysicalDeviceProperties properties;
+      vkGetPhysicalDeviceProperties(device, &properties);
+      const std::string name = properties.deviceName;
+      const bool preferred = !m_config.preferredDevice.empty() &&
+                             name.find(m_config.preferredDevice) != std::string::npos;
+
+      if (m_physicalDevice == VK_NULL_HANDLE || preferred) {
+        m_physicalDevice = device;
+        m_queueFamilyIndex = i;
+        m_deviceName = name;
+        m_timestampPeriod = families[i].timestampValidBits
+                                ? properties.limits.timestampPeriod
+                                : 0.0;
+      }
+      break;
+    }
+  }
+
+  if (m_physicalDevice == VK_NULL_HANDLE) {
+    throw std::runtime_error("OffscreenRenderer::pickPhysicalDevice(): No "
+                             "device with a graphics queue.");
+  }
+}
+
+void OffscreenRenderer::createDevice() {
+  float priority = 1.0f;
+  VkDeviceQueueCreateInfo queueInfo{};
+  queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queueInfo.queueFamilyIndex = m_queueFamilyIndex;
+  queueInfo.queueCount = 1;
+  queueInfo.pQueuePriorities = &priority;
+
+  // BC1 textures need textureCompressionBC; without it they stay RGBA8. The
+  // fragment shader indexes its texture array with a push constant.
+  VkPhysicalDeviceFeatures supported;
+  vkGetPhysicalDeviceFeatures(m_physicalDevice, &supported);
+  VkPhysicalDeviceFeatures features{};
+  features.textureCompressionBC = supported.textureCompressionBC;
+  features.shaderSampledImageArrayDynamicIndexing =
+      supported.shaderSampledImageArrayDynamicIndexing;
+  m_textureCompressionBC = supported.textureCompressionBC == VK_TRUE;
+  m_dynamicIndexing = supported.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+
+  VkDeviceCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.queueCreateInfoCount = 1;
+  createInfo.pQueueCreateInfos = &queueInfo;
+  createInfo.pEnabledFeatures = &features;
+
+  if (vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "OffscreenRenderer::createDevice(): Failed to create device.");
+  }
+  vkGetDeviceQueue(m_device, m_queueFamilyIndex, 0, &m_queue);
+
+  for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT,
+                          VK_FORMAT_D32_SFLOAT_S8_UINT}) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &properties);
+    if (properties.optimalTilingFeatures &
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      m_depthFormat = format;
+      break;
+    }
+  }
+  if (m_depthFormat == VK_FORMAT_UNDEFINED) {
+    throw std::runtime_error(
+        "OffscreenRenderer::createDevice(): No supported depth format.");
+  }
+}
+
+// Mirrors the QVulkanWindow default render pass (one color, one depth
+// attachment) so the same pipeline works for both targets.
+void OffscreenRenderer::createRenderPass() {
+  std::array<VkAttachmentDescription, 2> attachments{};
+  attachments[0].format = m_colorFormat;
+  attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  attachments[1].format = m_depthFormat;
+  attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  VkAttachmentReference depthRef{
+      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorRef;
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  VkSubpassDependency dependency{};
+  dependency.srcSubpass = 0;
+  dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  VkRenderPassCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  createInfo.pAttachments = attachments.data();
+  createInfo.subpassCount = 1;
+  createInfo.pSubpasses = &subpass;
+  createInfo.dependencyCount = 1;
+  createInfo.pDependencies = &dependency;
+
+  if (vkCreateRenderPass(m_device, &createInfo, nullptr, &m_renderPass) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "OffscreenRenderer::createRenderPass(): Failed to create render pass.");
+  }
+}
+
+void OffscreenRenderer::createImage(VkFormat format, VkImageUsageFlags usage,
+                                    VkImage &image, VkDeviceMemory &memory) {
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = format;
+  imageInfo.extent = {m_config.width, m_config.height, 1};
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = usage;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  if (vkCreateImage(m_device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create offscreen image.");
+  }
+
+  VkMemoryRequirements memRequirements;
+  vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = memRequirements.size;
+  allocInfo.memoryTypeIndex = m_core.findMemoryType(
+      memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  if (vkAllocateMemory(m_device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to allocate offscreen image memory.");
+  }
+  vkBindImageMemory(m_device, image, memory, 0);
+}
+
+VkImageView OffscreenRenderer::createImageView(VkImage image, VkFormat format,
+                                               VkImageAspectFlags aspect) {
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = format;
+  viewInfo.subresourceRange = {aspect, 0, 1, 0, 1};
+
+  VkImageView view;
+  if (vkCreateImageView(m_device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create offscreen image view.");
+  }
+  return view;
+}
+
+void OffscreenRenderer::createTargets() {
+  createImage(m_colorFormat,
+              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+              m_colorImage, m_colorMemory);
+  m_colorView =
+      createImageView(m_colorImage, m_colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+  createImage(m_depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+              m_depthImage, m_depthMemory);
+  m_depthView =
+      createImageView(m_depthImage, m_depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+  std::array<VkImageView, 2> views = {m_colorView, m_depthView};
+  VkFramebufferCreateInfo framebufferInfo{};
+  framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebufferInfo.renderPass = m_renderPass;
+  framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+  framebufferInfo.pAttachments = views.data();
+  framebufferInfo.width = m_config.width;
+  framebufferInfo.height = m_config.height;
+  framebufferInfo.layers = 1;
+
+  if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr,
+                          &m_framebuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create offscreen framebuffer.");
+  }
+}
+
+void OffscreenRenderer::createCommandResources() {
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  poolInfo.queueFamilyIndex = m_queueFamilyIndex;
+  if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to create offscreen command pool.");
+  }
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = m_commandPool;
+  allocInfo.commandBufferCount = 1;
+  if (vkAllocateCommandBuffers(m_device, &allocInfo, &m_commandBuffer) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to allocate offscreen command buffer.");
+  }
+
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  if (vkCreateFence(m_device, &fenceInfo, nullptr, &m_fence) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create offscreen fence.");
+  }
+}
+
+void OffscreenRenderer::createQueryPool() {
+  if (m_timestampPeriod == 0.0) {
+    return;
+  }
+  VkQueryPoolCreateInfo queryInfo{};
+  queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryInfo.queryCount = 2;
+  if (vkCreateQueryPool(m_device, &queryInfo, nullptr, &m_queryPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to create timestamp query pool.");
+  }
+}
+
+FrameTiming OffscreenRenderer::renderFrame() {
+  PROFILE_FUNCTION();
+  FrameTiming timing{};
+  const auto cpuStart = std::chrono::steady_clock::now();
+
+  vkResetCommandBuffer(m_commandBuffer, 0);
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(m_commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to begin offscreen command buffer.");
+  }
+
+  if (m_queryPool) {
+    vkCmdResetQueryPool(m_commandBuffer, m_queryPool, 0, 2);
+    vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        m_queryPool, 0);
+  }
+
+  m_core.recordFrame(m_commandBuffer, m_renderPass, m_framebuffer,
+                     {m_config.width, m_config.height});
+
+  if (m_queryPool) {
+    vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        m_queryPool, 1);
+  }
+
+  if (vkEndCommandBuffer(m_commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to end offscreen command buffer.");
+  }
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &m_commandBuffer;
+  if (vkQueueSubmit(m_queue, 1, &submitInfo, m_fence) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to submit offscreen frame.");
+  }
+
+  const auto cpuEnd = std::chrono::steady_clock::now();
+  timing.cpuMs =
+      std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+
+  vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, UINT64_MAX);
+  vkResetFences(m_device, 1, &m_fence);
+
+  if (m_queryPool) {
+    uint64_t timestamps[2] = {};
+    if (vkGetQueryPoolResults(m_device, m_queryPool, 0, 2, sizeof(timestamps),
+                              timestamps, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT |
+                                  VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS) {
+      timing.gpuMs = static_cast<double>(timestamps[1] - timestamps[0]) *
+                     m_timestampPeriod / 1e6;
+    }
+  }
+
+  return timing;
+}
+
+// Writes the last rendered color image as a binary PPM.
+void OffscreenRenderer::saveImage(const std::string &path) {
+  const VkDeviceSize size =
+      static_cast<VkDeviceSize>(m_config.width) * m_config.height * 4;
+  VkBuffer readback;
+  VkDeviceMemory readbackMemory;
+  m_core.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                      readback, readbackMemory);
+
+  vkResetCommandBuffer(m_commandBuffer, 0);
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(m_commandBuffer, &beginInfo);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent = {m_config.width, m_config.height, 1};
+  vkCmdCopyImageToBuffer(m_commandBuffer, m_colorImage,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1,
+                         &region);
+  vkEndCommandBuffer(m_commandBuffer);
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &m_commandBuffer;
+  vkQueueSubmit(m_queue, 1, &submitInfo, m_fence);
+  vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, UINT64_MAX);
+  vkResetFences(m_device, 1, &m_fence);
+
+  void *data;
+  vkMapMemory(m_device, readbackMemory, 0, size, 0, &data);
+  const auto *pixels = static_cast<const uint8_t *>(data);
+
+  std::ofstream file(path, std::ios::binary);
+  file << "P6\n" << m_config.width << " " << m_config.height << "\n255\n";
+  for (VkDeviceSize i = 0; i < size; i += 4) {
+    file.write(reinterpret_cast<const char *>(pixels + i), 3);
+  }
+
+  vkUnmapMemory(m_device, readbackMemory);
+  vkDestroyBuffer(m_device, readback, nullptr);
+  vkFreeMemory(m_device, readbackMemory, nullptr);
+}
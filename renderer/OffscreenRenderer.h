@@ -0,0 +1,83 @@
+#ifndef OFFSCREEN_RENDERER
+#define OFFSCREEN_RENDERER
+
+#include "RenderCore.h"
+#include <string>
+
+struct OffscreenConfig {
+  uint32_t width = 1280;
+  uint32_t height = 720;
+  std::string shaderDirectory;
+  // Substring of the physical device name to prefer, e.g. "llvmpipe".
+  std::string preferredDevice;
+  bool enableValidation = false;
+};
+
+struct FrameTiming {
+  double cpuMs = 0.0;
+  // Negative when the queue does not support timestamps.
+  double gpuMs = -1.0;
+};
+
+// Renders the RenderCore frame into an offscreen color/depth target without a
+// window or a QGuiApplication. Owns its own instance and device, so it needs
+// no display server.
+class OffscreenRenderer {
+public:
+  OffscreenRenderer(ResourceManager *resourceManager, World *world,
+                    const OffscreenConfig &config = {});
+  ~OffscreenRenderer();
+
+  OffscreenRenderer(const OffscreenRenderer &) = delete;
+  OffscreenRenderer &operator=(const OffscreenRenderer &) = delete;
+
+  FrameTiming renderFrame();
+  void saveImage(const std::string &path);
+
+  const std::string &deviceName() const { return m_deviceName; }
+  RenderCore &core() { return m_core; }
+
+private:
+  void createInstance();
+  void pickPhysicalDevice();
+  void createDevice();
+  void createRenderPass();
+  void createImage(VkFormat format, VkImageUsageFlags usage, VkImage &image,
+                   VkDeviceMemory &memory);
+  VkImageView createImageView(VkImage image, VkFormat format,
+                              VkImageAspectFlags aspect);
+  void createTargets();
+  void createCommandResources();
+  void createQueryPool();
+
+  OffscreenConfig m_config;
+  RenderCore m_core;
+  std::string m_deviceName;
+
+  VkInstance m_instance = VK_NULL_HANDLE;
+  VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkQueue m_queue = VK_NULL_HANDLE;
+  uint32_t m_queueFamilyIndex = 0;
+  bool m_textureCompressionBC = false;
+  bool m_dynamicIndexing = false;
+
+  VkFormat m_colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
+  VkImage m_colorImage = VK_NULL_HANDLE;
+  VkDeviceMemory m_colorMemory = VK_NULL_HANDLE;
+  VkImageView m_colorView = VK_NULL_HANDLE;
+  VkImage m_depthImage = VK_NULL_HANDLE;
+  VkDeviceMemory m_depthMemory = VK_NULL_HANDLE;
+  VkImageView m_depthView = VK_NULL_HANDLE;
+  VkRenderPass m_renderPass = VK_NULL_HANDLE;
+  VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+
+  VkCommandPool m_commandPool = VK_NULL_HANDLE;
+  VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+  VkFence m_fence = VK_NULL_HANDLE;
+  VkQueryPool m_queryPool = VK_NULL_HANDLE;
+  double m_timestampPeriod = 0.0;
+};
+
+#endif // OFFSCREEN_RENDERER
@@ -0,0 +1,1068 @@
+#include "RenderCore.h"
+#include "../core/JobSystem.h"
+#include "../core/Profiler.h"
+#include "../core/Stats.h"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Streamed sections handed to the renderer per frame, which caps the upload
+// work a loading mesh adds to one frame.
+constexpr size_t kStreamSectionsPerFrame = 4;
+// Transforms per job when computing model matrices.
+constexpr size_t kTransformGrain = 4096;
+// Room for a vertex and a fragment shader before the arena overflows.
+constexpr size_t kShaderArenaBytes = 64 << 10;
+// Push constants: the model matrix for the vertex stage, then the texture
+// slot for the fragment stage.
+constexpr uint32_t kTextureSlotOffset = sizeof(glm::mat4);
+// A uint32_t extent has at most 32 mip levels.
+constexpr size_t kMaxMipLevels = 32;
+
+VkFormat vulkanFormatOf(TextureFormat format) {
+  return format == TextureFormat::BC1 ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+                                      : VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+// Destroys a shader module when pipeline creation leaves scope, including by
+// a throw; shader hot reload survives failed builds and must not leak.
+struct ShaderModuleGuard {
+  VkDevice device;
+  VkShaderModule module;
+
+  ~ShaderModuleGuard() { vkDestroyShaderModule(device, module, nullptr); }
+};
+
+// Looked up once; every renderer in the process publishes to the same stats.
+struct RenderStats {
+  StatCounter &frames = Stats::counter("render.frames");
+  StatHistogram &frameTime = Stats::histogram("render.frame_time_us");
+  StatHistogram &cpuTime = Stats::histogram("render.cpu_time_us");
+  StatGauge &drawCalls = Stats::gauge("render.draw_calls");
+  StatGauge &triangles = Stats::gauge("render.triangles");
+  StatGauge &skippedEntities = Stats::gauge("render.skipped_entities");
+  StatHistogram &uploadBytes = Stats::histogram("render.upload_bytes");
+  StatCounter &uploadBytesTotal = Stats::counter("render.upload_bytes_total");
+  StatGauge &allocations = Stats::gauge("render.allocations");
+  StatGauge &cacheHits = Stats::gauge("resources.cache_hits");
+  StatGauge &cacheMisses = Stats::gauge("resources.cache_misses");
+  StatGauge &evictions = Stats::gauge("resources.evictions");
+  StatGauge &cpuBytes = Stats::gauge("resources.cpu_bytes");
+  StatGauge &texturesLoaded = Stats::gauge("resources.textures_loaded");
+  StatGauge &textureCacheHits = Stats::gauge("resources.texture_cache_hits");
+  StatGauge &meshGpuBytes = Stats::gauge("gpu.mesh_bytes");
+  StatGauge &textureGpuBytes = Stats::gauge("gpu.texture_bytes");
+  StatGauge &gpuBytes = Stats::gauge("gpu.memory_bytes");
+};
+
+RenderStats &renderStats() {
+  static RenderStats stats;
+  return stats;
+}
+
+}
+
+RenderCore::RenderCore(ResourceManager *resourceManager, World *world)
+    : m_resourceManager(resourceManager), m_world(world) {}
+
+RenderCore::~RenderCore() {}
+
+void RenderCore::initResources(const VulkanContext &context,
+                               VkRenderPass renderPass) {
+  m_context = context;
+  m_device = context.device;
+  m_renderPass = renderPass;
+  // Registers the stats now rather than in the first frame.
+  renderStats();
+
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  poolInfo.queueFamilyIndex = context.graphicsQueueFamilyIndex;
+
+  if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "RenderCore::initResources(): Failed to create command pool.");
+  }
+
+  // frag.spv picks its texture with a push-constant index into the array.
+  if (!context.sampledImageArrayDynamicIndexing) {
+    throw std::runtime_error("RenderCore::initResources(): the device lacks "
+                             "shaderSampledImageArrayDynamicIndexing.");
+  }
+  createTextureSampler();
+  m_defaultTexture.data.format = TextureFormat::RGBA8;
+  m_defaultTexture.data.mips = {{1, 1, 0, 4}};
+  m_defaultTexture.data.bytes = {255, 255, 255, 255};
+  createTextureImage(m_defaultTexture);
+  m_defaultTexture.slot = TextureDescriptors::kDefaultSlot;
+  m_textureDescriptors.init(context.physicalDevice, m_device,
+                            context.framesInFlight, m_sampler,
+                            m_defaultTexture.view);
+
+  createPipelineLayout();
+  createGraphicsPipeline(renderPass);
+  // Shaders follow the resource manager's setting so callers that only
+  // configure the scene (main, the Qt window) get both.
+  if (m_resourceManager && m_resourceManager->hotReload()) {
+    m_hotReload = true;
+  }
+  watchShaders();
+  m_gpuProfiler.init(context.physicalDevice, m_device,
+                     context.graphicsQueueFamilyIndex, context.framesInFlight);
+
+  if (m_resourceManager) {
+    m_resourceManager->setGpuReleaser(
+        [this](Mesh &mesh) { destroyMeshBuffersDeferred(mesh); });
+    m_resourceManager->setTextureUploader(
+        [this](Texture &texture) { return uploadTexture(texture); });
+    m_resourceManager->setTextureReleaser(
+        [this](Texture &texture) { destroyTextureDeferred(texture); });
+    if (!context.textureCompressionBC &&
+        m_resourceManager->textureOptions().compress) {
+      TextureOptions options = m_resourceManager->textureOptions();
+      options.compress = false;
+      m_resourceManager->setTextureOptions(options);
+      std::cout << "RenderCore: no BC texture support, textures stay uncompressed"
+                << std::endl;
+    }
+  }
+}
+
+std::string RenderCore::shaderPath(const std::string &filename) const {
+    if (!m_shaderDirectory.empty()) {
+        return (std::filesystem::path(m_shaderDirectory) / filename).string();
+    }
+#ifdef SGE_SHADER_DIRECTORY
+    // Where the build compiled shaders/ to.
+    return (std::filesystem::path(SGE_SHADER_DIRECTORY) / filename).string();
+#else
+    return filename;
+#endif
+}
+
+std::pmr::vector<uint32_t> RenderCore::readSpirv(const std::string& filename,
+                                                 std::pmr::memory_resource* resource) {
+    const std::filesystem::path path = shaderPath(filename);
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << path << "\n";
+        std::cerr << "Current working directory: " << std::filesystem::current_path() << "\n";
+        throw std::runtime_error("failed to open file: " + path.string());
+    }
+
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("not a SPIR-V file: " + path.string());
+    }
+    std::pmr::vector<uint32_t> buffer(fileSize / sizeof(uint32_t), resource);
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+    file.close();
+
+    return buffer;
+}
+
+VkShaderModule RenderCore::createShaderModule(std::span<const uint32_t> code) {
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size_bytes();
+    createInfo.pCode = code.data();
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create shader module.");
+    }
+    return shaderModule;
+}
+
+void RenderCore::createPipelineLayout() {
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    std::array<VkPushConstantRange, 2> pushConstantRanges{};
+    pushConstantRanges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRanges[0].offset = 0;
+    pushConstantRanges[0].size = sizeof(glm::mat4);
+    pushConstantRanges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRanges[1].offset = kTextureSlotOffset;
+    pushConstantRanges[1].size = sizeof(uint32_t);
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+    // The one set every pipeline shares: all textures, indexed by the slot.
+    const VkDescriptorSetLayout textureLayout = m_textureDescriptors.layout();
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &textureLayout;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout.");
+    }
+}
+
+void RenderCore::createGraphicsPipeline(VkRenderPass renderPass) {
+    // Both files die with this call, so they share one load-scoped block.
+    LinearArena loadArena(kShaderArenaBytes);
+    auto fragShaderCode = readSpirv("frag.spv", &loadArena);
+    auto vertShaderCode = readSpirv("vert.spv", &loadArena);
+    const ShaderModuleGuard vertShaderModule{m_device, createShaderModule(vertShaderCode)};
+    const ShaderModuleGuard fragShaderModule{m_device, createShaderModule(fragShaderCode)};
+
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = vertShaderModule.module;
+    vertShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module = fragShaderModule.module;
+    fragShaderStageInfo.pName = "main";
+    // constant_id 0 sizes the shader's texture array to the bound one.
+    const uint32_t textureCount = m_textureDescriptors.capacity();
+    const VkSpecializationMapEntry textureCountEntry{0, 0, sizeof(uint32_t)};
+    VkSpecializationInfo fragSpecialization{};
+    fragSpecialization.mapEntryCount = 1;
+    fragSpecialization.pMapEntries = &textureCountEntry;
+    fragSpecialization.dataSize = sizeof(textureCount);
+    fragSpecialization.pData = &textureCount;
+    fragShaderStageInfo.pSpecializationInfo = &fragSpecialization;
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    constexpr auto bindingDescription = VertexLayoutOf<Node>::bindingDescription();
+    constexpr auto attributeDescriptions = VertexLayoutOf<Node>::attributeDescriptions();
+
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Both the QVulkanWindow default render pass and the offscreen one carry a
+    // depth attachment, so the pipeline has to describe depth state.
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f;
+    colorBlending.blendConstants[1] = 0.0f;
+    colorBlending.blendConstants[2] = 0.0f;
+    colorBlending.blendConstants[3] = 0.0f;
+
+    const std::array<VkDynamicState, 2> dynamicStates = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = m_pipelineLayout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    const VkResult result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline);
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline.");
+    }
+}
+
+void RenderCore::setHotReload(bool enabled) {
+    m_hotReload = enabled;
+    if (m_resourceManager) {
+        m_resourceManager->setHotReload(enabled);
+    }
+    watchShaders();
+}
+
+void RenderCore::watchShaders() {
+    for (const char *shader : {"vert.spv", "frag.spv"}) {
+        if (m_hotReload) {
+            m_shaderWatcher.watch(shaderPath(shader));
+        }
+        else {
+            m_shaderWatcher.unwatch(shaderPath(shader));
+        }
+    }
+}
+
+void RenderCore::reloadChangedShaders() {
+    if (!m_hotReload || m_shaderWatcher.poll().empty()) {
+        return;
+    }
+    PROFILE_FUNCTION();
+    // Only one pipeline exists and it is built from both stages, so any
+    // change rebuilds exactly that pipeline.
+    const VkPipeline previous = m_graphicsPipeline;
+    try {
+        createGraphicsPipeline(m_renderPass);
+    }
+    catch (const std::exception &e) {
+        std::cerr << "RenderCore: shader reload failed, keeping previous pipeline: "
+                  << e.what() << std::endl;
+        m_graphicsPipeline = previous;
+        return;
+    }
+    // Frames still in flight were recorded with the previous pipeline.
+    m_pendingReleases.push_back({m_frameIndex, {}, {}, previous});
+    std::cout << "RenderCore: reloaded shaders" << std::endl;
+}
+
+uint32_t RenderCore::findMemoryType(uint32_t typeFilter,
+                                    VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_context.physicalDevice, &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) &&
+            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if (typeFilter & (1 << i)) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type.");
+}
+
+void RenderCore::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                              VkMemoryPropertyFlags properties,
+                              VkBuffer &buffer, VkDeviceMemory &bufferMemory) {
+    if (size == 0) {
+        buffer = VK_NULL_HANDLE;
+        bufferMemory = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create buffer");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+
+    try {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+                                                 properties);
+    } catch (const std::exception& e) {
+        std::cerr << "Memory type requirements:\n";
+        std::cerr << " - Size: " << memRequirements.size << "\n";
+        std::cerr << " - Alignment: " << memRequirements.alignment << "\n";
+        std::cerr << " - Memory type bits: " << memRequirements.memoryTypeBits << "\n";
+        std::cerr << " - Properties requested: " << properties << "\n";
+        throw;
+    }
+
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+        std::stringstream ss;
+        ss << "Failed to allocate buffer memory (size: "
+           << memRequirements.size << " bytes, type: "
+           << allocInfo.memoryTypeIndex << ")";
+        throw std::runtime_error(ss.str());
+    }
+
+    vkBindBufferMemory(m_device, buffer, bufferMemory, 0);
+}
+
+VkCommandBuffer RenderCore::beginImmediateCommands(const char *zone) {
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = m_commandPool;
+  allocInfo.commandBufferCount = 1;
+
+  VkCommandBuffer commandBuffer;
+  if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to allocate command buffer.");
+  }
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to begin command buffer");
+  }
+
+  m_gpuProfiler.beginImmediate(commandBuffer);
+  m_gpuProfiler.beginZone(commandBuffer, zone);
+  return commandBuffer;
+}
+
+void RenderCore::submitImmediateCommands(VkCommandBuffer commandBuffer) {
+  m_gpuProfiler.endZone(commandBuffer);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to end command buffer.");
+  }
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &commandBuffer;
+
+  vkQueueSubmit(m_context.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  vkQueueWaitIdle(m_context.graphicsQueue);
+  m_gpuProfiler.endImmediate();
+
+  vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+}
+
+void RenderCore::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
+                            VkDeviceSize size) {
+  PROFILE_FUNCTION();
+  VkCommandBuffer commandBuffer = beginImmediateCommands("copyBuffer");
+  VkBufferCopy copyRegion{};
+  copyRegion.size = size;
+  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+  submitImmediateCommands(commandBuffer);
+  m_frameStats.uploadBytes += size;
+}
+
+void RenderCore::createTextureSampler() {
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_LINEAR;
+  samplerInfo.minFilter = VK_FILTER_LINEAR;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  samplerInfo.minLod = 0.0f;
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+  if (vkCreateSampler(m_device, &samplerInfo, nullptr, &m_sampler) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to create texture sampler.");
+  }
+}
+
+size_t RenderCore::uploadTexture(Texture &texture) {
+  // Loads queued before the device existed still compress, whatever
+  // initResources later decided for this device.
+  if (texture.data.format == TextureFormat::BC1 &&
+      !m_context.textureCompressionBC) {
+    texture.data = decompressBC1(texture.data);
+  }
+  const VkDeviceSize bytes = createTextureImage(texture);
+  if (bytes) {
+    texture.slot = m_textureDescriptors.add(texture.view);
+  }
+  return static_cast<size_t>(bytes);
+}
+
+VkDeviceSize RenderCore::createTextureImage(Texture &texture) {
+  PROFILE_FUNCTION();
+  const TextureData &data = texture.data;
+  if (data.empty() || data.mips.size() > kMaxMipLevels) {
+    std::cerr << "RenderCore::uploadTexture: nothing to upload for "
+              << texture.source << "\n";
+    return 0;
+  }
+  const VkDeviceSize size = data.bytes.size();
+  const auto mipLevels = static_cast<uint32_t>(data.mips.size());
+  const VkFormat format = vulkanFormatOf(data.format);
+
+  VkBuffer stagingBuffer;
+  VkDeviceMemory stagingBufferMemory;
+  createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               stagingBuffer, stagingBufferMemory);
+
+  void *mapped;
+  vkMapMemory(m_device, stagingBufferMemory, 0, size, 0, &mapped);
+  memcpy(mapped, data.bytes.data(), static_cast<size_t>(size));
+  vkUnmapMemory(m_device, stagingBufferMemory);
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = format;
+  imageInfo.extent = {data.mips[0].width, data.mips[0].height, 1};
+  imageInfo.mipLevels = mipLevels;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  if (vkCreateImage(m_device, &imageInfo, nullptr, &texture.image) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create texture image.");
+  }
+
+  VkMemoryRequirements memRequirements;
+  vkGetImageMemoryRequirements(m_device, texture.image, &memRequirements);
+
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = memRequirements.size;
+  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (vkAllocateMemory(m_device, &allocInfo, nullptr, &texture.memory) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to allocate texture memory.");
+  }
+  vkBindImageMemory(m_device, texture.image, texture.memory, 0);
+
+  VkCommandBuffer commandBuffer = beginImmediateCommands("uploadTexture");
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = texture.image;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  // The mips were built on the CPU, so every level is a plain copy.
+  std::array<VkBufferImageCopy, kMaxMipLevels> regions{};
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    const TextureMip &mip = data.mips[level];
+    regions[level].bufferOffset = mip.offset;
+    regions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+    regions[level].imageExtent = {mip.width, mip.height, 1};
+  }
+  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, texture.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels,
+                         regions.data());
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  submitImmediateCommands(commandBuffer);
+
+  vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+  vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+  m_frameStats.uploadBytes += size;
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = texture.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = format;
+  viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+  if (vkCreateImageView(m_device, &viewInfo, nullptr, &texture.view) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create texture image view.");
+  }
+  return memRequirements.size;
+}
+
+void RenderCore::destroyTextureImage(Texture &texture) {
+  if (texture.view) vkDestroyImageView(m_device, texture.view, nullptr);
+  if (texture.image) vkDestroyImage(m_device, texture.image, nullptr);
+  if (texture.memory) vkFreeMemory(m_device, texture.memory, nullptr);
+  texture.view = VK_NULL_HANDLE;
+  texture.image = VK_NULL_HANDLE;
+  texture.memory = VK_NULL_HANDLE;
+  texture.slot = kNoTextureSlot;
+}
+
+void RenderCore::destroyTextureDeferred(Texture &texture) {
+  m_textureDescriptors.remove(texture.slot);
+  PendingRelease release{m_frameIndex, {}, {}};
+  release.image = texture.image;
+  release.imageView = texture.view;
+  release.imageMemory = texture.memory;
+  m_pendingReleases.push_back(release);
+  texture.view = VK_NULL_HANDLE;
+  texture.image = VK_NULL_HANDLE;
+  texture.memory = VK_NULL_HANDLE;
+  texture.slot = kNoTextureSlot;
+}
+
+void RenderCore::createMeshBuffers(Mesh &mesh) {
+  const VkDeviceSize uploaded = uploadGeometry(mesh);
+  if (uploaded && m_resourceManager) {
+    m_resourceManager->onMeshUploaded(mesh, static_cast<size_t>(uploaded));
+  }
+}
+
+void RenderCore::uploadSections(Mesh &mesh) {
+  VkDeviceSize uploaded = 0;
+  for (auto &section : mesh.sections) {
+    if (section.vertexBuffer || section.nodes.empty()) {
+      continue;
+    }
+    uploaded += uploadGeometry(section);
+    // Never needed on the CPU again; this is what bounds streaming memory.
+    std::vector<Node>().swap(section.nodes);
+    std::vector<uint32_t>().swap(section.indices);
+  }
+  if (uploaded && m_resourceManager) {
+    m_resourceManager->onMeshUploaded(mesh, static_cast<size_t>(uploaded));
+  }
+}
+
+VkDeviceSize RenderCore::uploadGeometry(Mesh &mesh) {
+  PROFILE_FUNCTION();
+  VkDeviceSize vertexBufferSize = sizeof(Node) * mesh.nodes.size();
+  VkDeviceSize indexBufferSize = sizeof(uint32_t) * mesh.indices.size();
+  if (mesh.nodes.empty() || mesh.indices.empty()) {
+    std::cerr << "RenderCore::createMeshBuffers: mesh has no "
+              << (mesh.nodes.empty() ? "vertices" : "indices") << "\n";
+    return 0;
+  }
+
+  VkBuffer vertexStagingBuffer;
+  VkDeviceMemory vertexStagingBufferMemory;
+  createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               vertexStagingBuffer, vertexStagingBufferMemory);
+
+  void *data;
+  vkMapMemory(m_device, vertexStagingBufferMemory, 0, vertexBufferSize, 0, &data);
+  memcpy(data, mesh.nodes.data(), static_cast<size_t>(vertexBufferSize));
+  vkUnmapMemory(m_device, vertexStagingBufferMemory);
+
+  createBuffer(vertexBufferSize,
+               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.vertexBuffer,
+               mesh.vertexBufferMemory);
+
+  copyBuffer(vertexStagingBuffer, mesh.vertexBuffer, vertexBufferSize);
+
+  VkBuffer indexStagingBuffer;
+  VkDeviceMemory indexStagingBufferMemory;
+  createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               indexStagingBuffer, indexStagingBufferMemory);
+
+  vkMapMemory(m_device, indexStagingBufferMemory, 0, indexBufferSize, 0, &data);
+  memcpy(data, mesh.indices.data(), static_cast<size_t>(indexBufferSize));
+  vkUnmapMemory(m_device, indexStagingBufferMemory);
+
+  createBuffer(indexBufferSize,
+               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.indexBuffer,
+               mesh.indexBufferMemory);
+
+  copyBuffer(indexStagingBuffer, mesh.indexBuffer, indexBufferSize);
+
+  vkDestroyBuffer(m_device, vertexStagingBuffer, nullptr);
+  vkFreeMemory(m_device, vertexStagingBufferMemory, nullptr);
+  vkDestroyBuffer(m_device, indexStagingBuffer, nullptr);
+  vkFreeMemory(m_device, indexStagingBufferMemory, nullptr);
+
+  mesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+  return vertexBufferSize + indexBufferSize;
+}
+
+void RenderCore::destroyMeshBuffers(Mesh& mesh) {
+    if (mesh.vertexBuffer) vkDestroyBuffer(m_device, mesh.vertexBuffer, nullptr);
+    if (mesh.vertexBufferMemory) vkFreeMemory(m_device, mesh.vertexBufferMemory, nullptr);
+    if (mesh.indexBuffer) vkDestroyBuffer(m_device, mesh.indexBuffer, nullptr);
+    if (mesh.indexBufferMemory) vkFreeMemory(m_device, mesh.indexBufferMemory, nullptr);
+
+    mesh.vertexBuffer = VK_NULL_HANDLE;
+    mesh.vertexBufferMemory = VK_NULL_HANDLE;
+    mesh.indexBuffer = VK_NULL_HANDLE;
+    mesh.indexBufferMemory = VK_NULL_HANDLE;
+
+    for (auto &section : mesh.sections) {
+        destroyMeshBuffers(section);
+    }
+    // Uploaded sections have no CPU copy left to upload again.
+    mesh.sections.clear();
+}
+
+void RenderCore::destroyMeshBuffersDeferred(Mesh &mesh) {
+    for (auto &section : mesh.sections) {
+        destroyMeshBuffersDeferred(section);
+    }
+    mesh.sections.clear();
+
+    if (!mesh.vertexBuffer && !mesh.indexBuffer) {
+        return;
+    }
+    m_pendingReleases.push_back({m_frameIndex,
+                                 {mesh.vertexBuffer, mesh.indexBuffer},
+                                 {mesh.vertexBufferMemory, mesh.indexBufferMemory}});
+    mesh.vertexBuffer = VK_NULL_HANDLE;
+    mesh.vertexBufferMemory = VK_NULL_HANDLE;
+    mesh.indexBuffer = VK_NULL_HANDLE;
+    mesh.indexBufferMemory = VK_NULL_HANDLE;
+}
+
+void RenderCore::releaseUnusedMeshes() {
+    std::erase_if(m_uncachedMeshes, [&](const std::shared_ptr<Mesh> &mesh) {
+        if (mesh.use_count() > 1) {
+            return false;
+        }
+        destroyMeshBuffersDeferred(*mesh);
+        return true;
+    });
+}
+
+void RenderCore::collectPendingReleases(bool all) {
+    auto retired = [&](const PendingRelease &release) {
+        return all || release.frame + m_context.framesInFlight < m_frameIndex;
+    };
+    for (const auto &release : m_pendingReleases) {
+        if (!retired(release)) {
+            continue;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (release.buffers[i]) vkDestroyBuffer(m_device, release.buffers[i], nullptr);
+            if (release.memory[i]) vkFreeMemory(m_device, release.memory[i], nullptr);
+        }
+        if (release.pipeline) vkDestroyPipeline(m_device, release.pipeline, nullptr);
+        if (release.imageView) vkDestroyImageView(m_device, release.imageView, nullptr);
+        if (release.image) vkDestroyImage(m_device, release.image, nullptr);
+        if (release.imageMemory) vkFreeMemory(m_device, release.imageMemory, nullptr);
+    }
+    std::erase_if(m_pendingReleases, retired);
+}
+
+void RenderCore::releaseResources() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    vkDeviceWaitIdle(m_device);
+
+    if (m_resourceManager) {
+        m_resourceManager->releaseGpuResources();
+        m_resourceManager->setGpuReleaser(nullptr);
+        m_resourceManager->setTextureUploader(nullptr);
+        m_resourceManager->setTextureReleaser(nullptr);
+    }
+
+    // Whichever snapshot or entities still hold them, no frame draws them now.
+    for (const auto &mesh : m_uncachedMeshes) {
+        destroyMeshBuffers(*mesh);
+    }
+    m_uncachedMeshes.clear();
+
+    collectPendingReleases(true);
+    m_gpuProfiler.release();
+
+    destroyTextureImage(m_defaultTexture);
+    m_textureDescriptors.release();
+    if (m_sampler) {
+        vkDestroySampler(m_device, m_sampler, nullptr);
+        m_sampler = VK_NULL_HANDLE;
+    }
+
+    if (m_graphicsPipeline) {
+        vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
+        m_graphicsPipeline = VK_NULL_HANDLE;
+    }
+
+    if (m_pipelineLayout) {
+        vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+        m_pipelineLayout = VK_NULL_HANDLE;
+    }
+
+    if (m_commandPool) {
+        vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+        m_commandPool = VK_NULL_HANDLE;
+    }
+    m_device = VK_NULL_HANDLE;
+}
+
+void RenderCore::drawMesh(VkCommandBuffer cmdBuf, const Mesh &mesh) {
+  if (!mesh.vertexBuffer || !mesh.indexBuffer) {
+    return;
+  }
+  VkBuffer vertexBuffers[] = {mesh.vertexBuffer};
+  VkDeviceSize offsets[] = {0};
+  vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+  vkCmdBindIndexBuffer(cmdBuf, mesh.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+  vkCmdDrawIndexed(cmdBuf, mesh.indexCount, 1, 0, 0, 0);
+  m_frameStats.drawCalls++;
+  m_frameStats.triangles += mesh.indexCount / 3;
+}
+
+void RenderCore::updateModelMatrices(const RenderSnapshot *snapshot) {
+  PROFILE_FUNCTION();
+  if (snapshot) {
+    const float alpha = snapshot->alpha(std::chrono::steady_clock::now());
+    const auto &instances = snapshot->instances;
+    m_modelMatrices.resize(instances.size());
+    JobSystem::global().parallelFor(0, instances.size(), kTransformGrain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        m_modelMatrices[i] =
+            TransformState::lerp(instances[i].previous, instances[i].current, alpha).modelMatrix();
+      }
+    });
+    return;
+  }
+
+  const auto &renders = m_world->storage<RenderElement>();
+  const auto &transforms = m_world->storage<TransformElement>();
+  m_modelMatrices.resize(renders.size());
+  JobSystem::global().parallelFor(0, renders.size(), kTransformGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (const TransformElement *transform = transforms.get(renders.entities()[i])) {
+        m_modelMatrices[i] = transform->modelMatrix();
+      }
+    }
+  });
+}
+
+void RenderCore::recordDraw(VkCommandBuffer cmdBuf, const std::shared_ptr<Mesh> &meshPtr,
+                            const glm::mat4 &model, const Texture *texture) {
+  Mesh &mesh = *meshPtr;
+  if (mesh.streamed) {
+    if (mesh.sections.empty() && m_resourceManager) {
+      m_resourceManager->restoreCpuCopy(mesh);
+    }
+    uploadSections(mesh);
+  }
+  else if (!mesh.vertexBuffer || !mesh.indexBuffer) {
+    if (mesh.nodes.empty() && m_resourceManager) {
+      m_resourceManager->restoreCpuCopy(mesh);
+    }
+    // A file without faces loads as an empty mesh; nothing to upload or draw.
+    if (mesh.nodes.empty() || mesh.indices.empty()) {
+      return;
+    }
+    createMeshBuffers(mesh);
+    if (!mesh.vertexBuffer || !mesh.indexBuffer) {
+      return;
+    }
+    if (!m_resourceManager || !m_resourceManager->isCached(mesh)) {
+      m_uncachedMeshes.push_back(meshPtr);
+    }
+  }
+
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+                     0, sizeof(glm::mat4), &model);
+  // Consecutive draws usually share a texture; the slot is pushed on change.
+  const uint32_t slot = texture && texture->slot != kNoTextureSlot
+                            ? texture->slot
+                            : TextureDescriptors::kDefaultSlot;
+  if (slot != m_pushedTextureSlot) {
+    vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT,
+                       kTextureSlotOffset, sizeof(uint32_t), &slot);
+    m_pushedTextureSlot = slot;
+  }
+
+  if (mesh.streamed) {
+    for (const auto &section : mesh.sections) {
+      drawMesh(cmdBuf, section);
+    }
+  }
+  else {
+    drawMesh(cmdBuf, mesh);
+  }
+}
+
+void RenderCore::recordFrame(VkCommandBuffer cmdBuf, VkRenderPass renderPass,
+                             VkFramebuffer framebuffer, VkExtent2D extent) {
+  PROFILE_FUNCTION();
+  ALLOC_SCOPE(Subsystem::Renderer);
+  const AllocationCounts allocationsBefore = AllocationTracker::counts();
+  const uint64_t frameStartNs = Profiler::nowNs();
+  m_frameStats = FrameStats{};
+  m_frameIndex++;
+  m_frameArena.reset();
+  collectPendingReleases(false);
+  releaseUnusedMeshes();
+  reloadChangedShaders();
+  if (m_resourceManager) {
+    m_resourceManager->pollReloads();
+    m_resourceManager->pollStreams(kStreamSectionsPerFrame);
+    m_resourceManager->trim(&m_frameArena);
+    m_resourceManager->pollTextures();
+  }
+  // After pollTextures(): this frame's copy picks up the new slots.
+  const VkDescriptorSet textureSet = m_textureDescriptors.beginFrame();
+  m_pushedTextureSlot = kNoTextureSlot;
+
+  m_gpuProfiler.beginFrame(cmdBuf);
+  m_gpuProfiler.beginZone(cmdBuf, "RenderPass");
+
+  VkClearValue clearValues[2] = {
+      {{0.0f, 0.0f, 0.0f, 1.0f}},
+      {1.0f, 0}
+  };
+
+  VkRenderPassBeginInfo rpBeginInfo{};
+  rpBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  rpBeginInfo.renderPass = renderPass;
+  rpBeginInfo.framebuffer = framebuffer;
+  rpBeginInfo.renderArea = {{0, 0}, extent};
+  rpBeginInfo.clearValueCount = 2;
+  rpBeginInfo.pClearValues = clearValues;
+
+  vkCmdBeginRenderPass(cmdBuf, &rpBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          m_pipelineLayout, 0, 1, &textureSet, 0, nullptr);
+
+  VkViewport viewport{};
+  viewport.x = 0.0f;
+  viewport.y = 0.0f;
+  viewport.width = static_cast<float>(extent.width);
+  viewport.height = static_cast<float>(extent.height);
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+
+  VkRect2D scissor{};
+  scissor.offset = {0, 0};
+  scissor.extent = extent;
+
+  vkCmdSetViewport(cmdBuf, 0, 1, &viewport);
+  vkCmdSetScissor(cmdBuf, 0, 1, &scissor);
+
+  if (m_simulation) {
+    // The World belongs to the simulation thread; draw its latest snapshot.
+    const RenderSnapshot &snapshot = m_simulation->acquireSnapshot();
+    updateModelMatrices(&snapshot);
+    for (size_t i = 0; i < snapshot.instances.size(); i++) {
+      const RenderInstance &instance = snapshot.instances[i];
+      if (instance.mesh) {
+        recordDraw(cmdBuf, instance.mesh, m_modelMatrices[i], instance.texture.get());
+      }
+      else {
+        m_frameStats.skippedEntities++;
+      }
+    }
+  }
+  else {
+    updateModelMatrices(nullptr);
+    const auto &renders = m_world->storage<RenderElement>();
+    const auto &transforms = m_world->storage<TransformElement>();
+    for (size_t i = 0; i < renders.size(); i++) {
+      const RenderElement &render = renders.components()[i];
+      if (render.mesh && transforms.has(renders.entities()[i])) {
+        recordDraw(cmdBuf, render.mesh, m_modelMatrices[i], render.texture.get());
+      }
+      else {
+        m_frameStats.skippedEntities++;
+      }
+    }
+  }
+
+  vkCmdEndRenderPass(cmdBuf);
+  m_gpuProfiler.endZone(cmdBuf);
+  m_frameStats.allocations = AllocationTracker::counts() - allocationsBefore;
+  publishStats(frameStartNs);
+}
+
+void RenderCore::publishStats(uint64_t frameStartNs) {
+  RenderStats &stats = renderStats();
+  const uint64_t nowNs = Profiler::nowNs();
+  stats.frames.add();
+  // Start to start, so it includes the wait for the swapchain image.
+  if (m_lastFrameStartNs) {
+    stats.frameTime.record((frameStartNs - m_lastFrameStartNs) / 1000);
+  }
+  m_lastFrameStartNs = frameStartNs;
+  stats.cpuTime.record((nowNs - frameStartNs) / 1000);
+  stats.drawCalls.set(m_frameStats.drawCalls);
+  stats.triangles.set(static_cast<int64_t>(m_frameStats.triangles));
+  stats.skippedEntities.set(m_frameStats.skippedEntities);
+  stats.uploadBytes.record(m_frameStats.uploadBytes);
+  stats.uploadBytesTotal.add(m_frameStats.uploadBytes);
+  stats.allocations.set(static_cast<int64_t>(m_frameStats.allocations.total()));
+
+  if (m_resourceManager) {
+    const CacheStats &cache = m_resourceManager->stats();
+    stats.cacheHits.set(static_cast<int64_t>(cache.hits));
+    stats.cacheMisses.set(static_cast<int64_t>(cache.misses));
+    stats.evictions.set(static_cast<int64_t>(cache.evictions));
+    stats.cpuBytes.set(static_cast<int64_t>(cache.cpuBytesResident));
+    stats.texturesLoaded.set(static_cast<int64_t>(cache.texturesLoaded));
+    stats.textureCacheHits.set(static_cast<int64_t>(cache.textureCacheHits));
+    stats.meshGpuBytes.set(static_cast<int64_t>(cache.gpuBytesResident));
+    stats.textureGpuBytes.set(static_cast<int64_t>(cache.textureBytesResident));
+    stats.gpuBytes.set(static_cast<int64_t>(cache.gpuBytesResident + cache.textureBytesResident));
+  }
+}
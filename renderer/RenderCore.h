@@ -0,0 +1,169 @@
+#ifndef RENDER_CORE
+#define RENDER_CORE
+
+#include "../resourceManager/FileWatcher.h"
+#include "../resourceManager/ResourceManager.h"
+#include "../resourceManager/Simulation.h"
+#include "../resourceManager/World.h"
+#include "../core/AllocationTracker.h"
+#include "../core/LinearArena.h"
+#include "GpuProfiler.h"
+#include "TextureDescriptors.h"
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// Device handles the renderer works with. Filled either from a QVulkanWindow
+// or from the headless OffscreenRenderer.
+struct VulkanContext {
+  VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+  VkDevice device = VK_NULL_HANDLE;
+  VkQueue graphicsQueue = VK_NULL_HANDLE;
+  uint32_t graphicsQueueFamilyIndex = 0;
+  uint32_t framesInFlight = 1;
+  // The device was created with textureCompressionBC enabled.
+  bool textureCompressionBC = false;
+  // The device was created with shaderSampledImageArrayDynamicIndexing.
+  bool sampledImageArrayDynamicIndexing = false;
+};
+
+struct FrameStats {
+  uint32_t drawCalls = 0;
+  uint64_t triangles = 0;
+  // Entities with a RenderElement that were not drawn because they have no
+  // mesh or no transform.
+  uint32_t skippedEntities = 0;
+  // Bytes copied to device memory through staging buffers.
+  uint64_t uploadBytes = 0;
+  // Heap allocations made by any thread while the frame was recorded. All
+  // zero unless the build has ENGINE_ALLOC_TRACKING enabled.
+  AllocationCounts allocations;
+};
+
+// Frame logic shared by the windowed and the headless renderer. Knows nothing
+// about the surface it draws to: the caller owns the command buffer, render
+// pass and framebuffer.
+class RenderCore {
+public:
+  RenderCore(ResourceManager *resourceManager, World *world);
+  ~RenderCore();
+
+  void initResources(const VulkanContext &context, VkRenderPass renderPass);
+  void releaseResources();
+  void recordFrame(VkCommandBuffer cmdBuf, VkRenderPass renderPass,
+                   VkFramebuffer framebuffer, VkExtent2D extent);
+
+  uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                    VkMemoryPropertyFlags properties, VkBuffer &buffer,
+                    VkDeviceMemory &bufferMemory);
+  void createMeshBuffers(Mesh &mesh);
+  // Uploads the sections of a streamed mesh that arrived since the last frame.
+  void uploadSections(Mesh &mesh);
+  void destroyMeshBuffers(Mesh &mesh);
+  // Detaches the buffers from the mesh and frees them once every frame that
+  // may still read them has retired.
+  void destroyMeshBuffersDeferred(Mesh &mesh);
+  // Uploads every mip level through one staging buffer and gives the texture
+  // a descriptor slot. Returns the device memory used.
+  size_t uploadTexture(Texture &texture);
+  // Frees the slot and, once no frame in flight may sample it, the image.
+  void destroyTextureDeferred(Texture &texture);
+
+  VkShaderModule createShaderModule(std::span<const uint32_t> code);
+  // SPIR-V words of a file in the shader directory.
+  std::pmr::vector<uint32_t> readSpirv(const std::string &filename,
+                                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+  void createPipelineLayout();
+  void createGraphicsPipeline(VkRenderPass renderPass);
+
+  // Draws interpolated simulation snapshots instead of reading the World,
+  // which then belongs to the simulation thread. Null reads the World.
+  void setSimulation(Simulation *simulation) { m_simulation = simulation; }
+
+  // Where vert.spv and frag.spv are read from; empty means the build's
+  // shader output directory.
+  void setShaderDirectory(const std::string &directory) { m_shaderDirectory = directory; }
+  // Reloads changed meshes and shaders at the start of each frame. Changed
+  // SPIR-V only rebuilds the pipelines built from it; if the new pipeline
+  // fails to build the old one stays in use.
+  void setHotReload(bool enabled);
+  const VulkanContext &context() const { return m_context; }
+  const FrameStats &lastFrameStats() const { return m_frameStats; }
+
+private:
+  static constexpr size_t kFrameArenaBytes = 64 << 10;
+
+  struct PendingRelease {
+    uint64_t frame;
+    VkBuffer buffers[2];
+    VkDeviceMemory memory[2];
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView imageView = VK_NULL_HANDLE;
+    VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+  };
+
+  void collectPendingReleases(bool all);
+  // Copies the finished frame's FrameStats and the resource manager's cache
+  // stats into the Stats registry.
+  void publishStats(uint64_t frameStartNs);
+  // One-shot command buffer for uploads; submit waits for it to finish.
+  VkCommandBuffer beginImmediateCommands(const char *zone);
+  void submitImmediateCommands(VkCommandBuffer commandBuffer);
+  // Creates the image and view of `texture` from its data; returns the bytes used.
+  VkDeviceSize createTextureImage(Texture &texture);
+  void destroyTextureImage(Texture &texture);
+  void createTextureSampler();
+  // Creates device-local buffers from nodes/indices, returns the bytes used.
+  VkDeviceSize uploadGeometry(Mesh &mesh);
+  void drawMesh(VkCommandBuffer cmdBuf, const Mesh &mesh);
+  // Fills m_modelMatrices as jobs: one per snapshot instance, or one per
+  // RenderElement without a snapshot.
+  void updateModelMatrices(const RenderSnapshot *snapshot);
+  // Uploads the mesh if needed and records its draw. A null or not yet
+  // uploaded texture draws with the default one.
+  void recordDraw(VkCommandBuffer cmdBuf, const std::shared_ptr<Mesh> &mesh,
+                  const glm::mat4 &model, const Texture *texture);
+  // Frees the buffers of uncached meshes nothing but m_uncachedMeshes refers to.
+  void releaseUnusedMeshes();
+  std::string shaderPath(const std::string &filename) const;
+  void watchShaders();
+  void reloadChangedShaders();
+
+  ResourceManager *m_resourceManager = nullptr;
+  World *m_world = nullptr;
+  Simulation *m_simulation = nullptr;
+  VulkanContext m_context{};
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkCommandPool m_commandPool = VK_NULL_HANDLE;
+  VkPipeline m_graphicsPipeline = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkRenderPass m_renderPass = VK_NULL_HANDLE;
+  std::string m_shaderDirectory;
+  FrameStats m_frameStats{};
+  GpuProfiler m_gpuProfiler;
+  std::vector<PendingRelease> m_pendingReleases;
+  std::vector<glm::mat4> m_modelMatrices;
+  // Meshes drawn with buffers of their own that the resource manager does not
+  // cache (generated, or inline in a snapshot); their buffers are freed here.
+  std::vector<std::shared_ptr<Mesh>> m_uncachedMeshes;
+  VkSampler m_sampler = VK_NULL_HANDLE;
+  // 1x1 white, in TextureDescriptors::kDefaultSlot.
+  Texture m_defaultTexture;
+  TextureDescriptors m_textureDescriptors;
+  // Texture slot last pushed in the frame being recorded.
+  uint32_t m_pushedTextureSlot = kNoTextureSlot;
+  // Transient data of one frame; reset when the next one starts.
+  LinearArena m_frameArena{kFrameArenaBytes};
+  uint64_t m_frameIndex = 0;
+  uint64_t m_lastFrameStartNs = 0;
+  bool m_hotReload = false;
+  FileWatcher m_shaderWatcher;
+};
+
+#endif // RENDER_CORE
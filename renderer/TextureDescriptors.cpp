@@ -0,0 +1,162 @@
+#include "TextureDescriptors.h"
+#include <algorithm>
+#include <stdexcept>
+
+void TextureDescriptors::init(VkPhysicalDevice physicalDevice, VkDevice device,
+                              uint32_t framesInFlight, VkSampler sampler,
+                              VkImageView defaultView) {
+  m_device = device;
+  m_sampler = sampler;
+  m_defaultView = defaultView;
+  framesInFlight = std::max(framesInFlight, 1u);
+
+  // Without descriptor indexing the whole array counts against the per-stage
+  // limits, which can be as low as 16.
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  const VkPhysicalDeviceLimits &limits = properties.limits;
+  const uint32_t capacity = std::min({kMaxTextures,
+                                      limits.maxPerStageDescriptorSamplers,
+                                      limits.maxPerStageDescriptorSampledImages,
+                                      limits.maxDescriptorSetSamplers,
+                                      limits.maxDescriptorSetSampledImages});
+
+  VkDescriptorSetLayoutBinding binding{};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  binding.descriptorCount = capacity;
+  binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = 1;
+  layoutInfo.pBindings = &binding;
+  if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_layout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "TextureDescriptors::init(): Failed to create descriptor set layout.");
+  }
+
+  VkDescriptorPoolSize poolSize{};
+  poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  poolSize.descriptorCount = capacity * framesInFlight;
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = framesInFlight;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "TextureDescriptors::init(): Failed to create descriptor pool.");
+  }
+
+  const std::vector<VkDescriptorSetLayout> layouts(framesInFlight, m_layout);
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = m_pool;
+  allocInfo.descriptorSetCount = framesInFlight;
+  allocInfo.pSetLayouts = layouts.data();
+  m_sets.resize(framesInFlight);
+  if (vkAllocateDescriptorSets(m_device, &allocInfo, m_sets.data()) !=
+      VK_SUCCESS) {
+    throw std::runtime_error(
+        "TextureDescriptors::init(): Failed to allocate descriptor sets.");
+  }
+
+  m_views.assign(capacity, m_defaultView);
+  m_dirty.assign(framesInFlight, {});
+  m_freeSlots.clear();
+  // Handed out lowest first.
+  for (uint32_t slot = capacity - 1; slot > kDefaultSlot; slot--) {
+    m_freeSlots.push_back(slot);
+  }
+  m_frameIndex = 0;
+
+  // Every slot starts on the default texture, in every copy.
+  m_imageInfos.assign(capacity, {m_sampler, m_defaultView,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+  m_writes.clear();
+  for (VkDescriptorSet set : m_sets) {
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = capacity;
+    write.pImageInfo = m_imageInfos.data();
+    m_writes.push_back(write);
+  }
+  vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(m_writes.size()),
+                         m_writes.data(), 0, nullptr);
+}
+
+void TextureDescriptors::release() {
+  if (m_pool) {
+    vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+    m_pool = VK_NULL_HANDLE;
+  }
+  if (m_layout) {
+    vkDestroyDescriptorSetLayout(m_device, m_layout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+  m_views.clear();
+  m_dirty.clear();
+  m_freeSlots.clear();
+}
+
+uint32_t TextureDescriptors::add(VkImageView view) {
+  if (m_freeSlots.empty()) {
+    return kDefaultSlot;
+  }
+  const uint32_t slot = m_freeSlots.back();
+  m_freeSlots.pop_back();
+  m_views[slot] = view;
+  markDirty(slot);
+  return slot;
+}
+
+void TextureDescriptors::remove(uint32_t slot) {
+  if (slot == kDefaultSlot || slot >= m_views.size()) {
+    return;
+  }
+  m_views[slot] = m_defaultView;
+  markDirty(slot);
+  m_freeSlots.push_back(slot);
+}
+
+void TextureDescriptors::markDirty(uint32_t slot) {
+  for (auto &dirty : m_dirty) {
+    dirty.push_back(slot);
+  }
+}
+
+VkDescriptorSet TextureDescriptors::beginFrame() {
+  const size_t index = m_frameIndex++ % m_sets.size();
+  std::vector<uint32_t> &dirty = m_dirty[index];
+  if (dirty.empty()) {
+    return m_sets[index];
+  }
+  // Sized before any pointer into it is taken.
+  m_imageInfos.resize(dirty.size());
+  m_writes.resize(dirty.size());
+  for (size_t i = 0; i < dirty.size(); i++) {
+    m_imageInfos[i] = {m_sampler, m_views[dirty[i]],
+                       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet &write = m_writes[i];
+    write = VkWriteDescriptorSet{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_sets[index];
+    write.dstBinding = 0;
+    write.dstArrayElement = dirty[i];
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &m_imageInfos[i];
+  }
+  vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(m_writes.size()),
+                         m_writes.data(), 0, nullptr);
+  dirty.clear();
+  return m_sets[index];
+}
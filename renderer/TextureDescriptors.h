@@ -0,0 +1,60 @@
+#ifndef TEXTURE_DESCRIPTORS
+#define TEXTURE_DESCRIPTORS
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// Every texture in one descriptor array, bound once per frame; draws select a
+// texture by slot through a push constant, so nothing is allocated, updated
+// or bound per draw.
+//
+// Each frame in flight has its own copy of the set. A slot change is written
+// into a copy only when that copy's frame begins, once the frame that last
+// used it has retired; no set is ever updated while the GPU may read it, and
+// no descriptor-indexing features are needed. Slot 0 is the default texture
+// and every free slot points at it.
+class TextureDescriptors {
+public:
+  static constexpr uint32_t kMaxTextures = 1024;
+  static constexpr uint32_t kDefaultSlot = 0;
+
+  void init(VkPhysicalDevice physicalDevice, VkDevice device,
+            uint32_t framesInFlight, VkSampler sampler,
+            VkImageView defaultView);
+  void release();
+
+  // Returns kDefaultSlot when the array is full.
+  uint32_t add(VkImageView view);
+  // The slot shows the default texture from the next frame of each copy on,
+  // and may be handed out again right away.
+  void remove(uint32_t slot);
+
+  // Writes pending slot changes into this frame's copy and returns it. Must
+  // be called once per frame, before the set is bound.
+  VkDescriptorSet beginFrame();
+
+  VkDescriptorSetLayout layout() const { return m_layout; }
+  uint32_t capacity() const { return static_cast<uint32_t>(m_views.size()); }
+
+private:
+  void markDirty(uint32_t slot);
+
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkSampler m_sampler = VK_NULL_HANDLE;
+  VkImageView m_defaultView = VK_NULL_HANDLE;
+  VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  std::vector<VkDescriptorSet> m_sets;
+  // Current view of every slot.
+  std::vector<VkImageView> m_views;
+  // Per copy: slots changed since the copy was last written.
+  std::vector<std::vector<uint32_t>> m_dirty;
+  std::vector<uint32_t> m_freeSlots;
+  // Reused by beginFrame() so steady frames do not allocate.
+  std::vector<VkDescriptorImageInfo> m_imageInfos;
+  std::vector<VkWriteDescriptorSet> m_writes;
+  uint64_t m_frameIndex = 0;
+};
+
+#endif // TEXTURE_DESCRIPTORS
@@ -2,7 +2,9 @@
 #define COMPONENTS
 
 #include "Resource.h"
+#include "Texture.h"
 #include <memory>
+#include <glm/gtc/matrix_transform.hpp>
 
 class Component {
 public:
@@ -13,10 +15,12 @@ inline Component::~Component() = default;
 
 class RenderElement : public Component {
 public:
-    RenderElement(std::shared_ptr<Mesh> m) : mesh(m) {}
+    RenderElement(std::shared_ptr<Mesh> m, std::shared_ptr<Texture> t = nullptr) : mesh(m), texture(t) {}
     ~RenderElement() override = default;
     
     std::shared_ptr<Mesh> mesh;
+    // Null draws with the renderer's default (white) texture.
+    std::shared_ptr<Texture> texture;
 };
 
 class TransformElement : public Component {
@@ -26,6 +30,15 @@ public:
     glm::vec3 position{0.0f, 0.0f, 0.0f};
     glm::vec3 rotation{0.0f, 0.0f, 0.0f};
     glm::vec3 scale{1.0f, 1.0f, 1.0f};
+
+    // Rotation is stored as XYZ euler angles in radians.
+    glm::mat4 modelMatrix() const {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::rotate(model, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+        return glm::scale(model, scale);
+    }
 };
 
 #endif // COMPONENTS
\ No newline at end of file
@@ -7,27 +7,20 @@
 
 using Entity = uint32_t;
 
+// Components of one entity, pointing into the World's component arrays.
+// Null when the entity lacks the component. Valid until the next component
+// of the same type is added or deleted.
 struct EntityStructure {
-	std::shared_ptr<RenderElement> render;
-	std::shared_ptr<TransformElement> transform;
+	RenderElement *render = nullptr;
+	TransformElement *transform = nullptr;
 
-	void add(std::shared_ptr<RenderElement>&& r) {
-		render = std::move(r);
-	}
-	void add(std::shared_ptr<TransformElement>&& t) {
-		transform = std::move(t);
-	}
-	void deleteEntity() {
-		render.reset();
-		transform.reset();
-	}
 	bool hasTransformElement() const {
-		return transform.get();
+		return transform;
 	}
 	bool hasRenderElement() const {
-		return render.get();
+		return render;
 	}
 };
 
 
-#endif // ENTITY
\ No newline at end of file
+#endif // ENTITY
@@ -0,0 +1,43 @@
+#include "FileWatcher.h"
+
+void FileWatcher::watch(const std::string &path) {
+    std::error_code error;
+    FileState state;
+    state.path = path;
+    state.time = std::filesystem::last_write_time(state.path, error);
+    state.size = std::filesystem::file_size(state.path, error);
+    m_files.insert_or_assign(path, state);
+}
+
+void FileWatcher::unwatch(const std::string &path) {
+    m_files.erase(path);
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_lastPoll < m_interval) {
+        return changed;
+    }
+    m_lastPoll = now;
+
+    for (auto &[path, state] : m_files) {
+        std::error_code timeError, sizeError;
+        const auto time = std::filesystem::last_write_time(state.path, timeError);
+        const auto size = std::filesystem::file_size(state.path, sizeError);
+        if (timeError || sizeError) {
+            // Editors often delete and recreate files on save.
+            continue;
+        }
+        if (time != state.time || size != state.size) {
+            state.time = time;
+            state.size = size;
+            state.pending = true;
+        }
+        else if (state.pending) {
+            state.pending = false;
+            changed.push_back(path);
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,42 @@
+#ifndef FILE_WATCHER
+#define FILE_WATCHER
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Polling file watcher. Works the same with and without a Qt event loop, so
+// the headless renderer gets hot reload too. Polls are rate limited, so it is
+// cheap to call once per frame.
+class FileWatcher {
+public:
+    explicit FileWatcher(std::chrono::milliseconds interval = std::chrono::milliseconds(250))
+        : m_interval(interval) {}
+
+    void watch(const std::string &path);
+    void unwatch(const std::string &path);
+    bool empty() const { return m_files.empty(); }
+
+    // Returns files whose timestamp or size changed and then stayed unchanged
+    // for one interval, so files still being written are not reported. Does
+    // not allocate unless something changed.
+    std::vector<std::string> poll();
+
+private:
+    struct FileState {
+        // Converted once: building a path from a string allocates.
+        std::filesystem::path path;
+        std::filesystem::file_time_type time{};
+        uintmax_t size = 0;
+        bool pending = false;
+    };
+
+    std::chrono::milliseconds m_interval;
+    std::chrono::steady_clock::time_point m_lastPoll{};
+    std::unordered_map<std::string, FileState> m_files;
+};
+
+#endif // FILE_WATCHER
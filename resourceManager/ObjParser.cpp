@@ -0,0 +1,291 @@
+#include "ObjParser.h"
+#include "ResourceManager.h"
+#include "../core/JobSystem.h"
+#include "../core/LinearArena.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+
+using namespace obj;
+
+// Ranges smaller than this are not worth a thread.
+constexpr size_t kMinRangeBytes = 256 << 10;
+// Load arena sizing for deduplication: a bucket, a FirstPair and a hash node
+// per position, so typical meshes never leave the arena's first block.
+constexpr size_t kLoadArenaBytesPerPosition = 96;
+
+// A triangle corner as written in the file. Negative indices only make sense
+// relative to the current element count, which a range does not know yet:
+// they are stored relative to the range start and rebased in the merge.
+struct Corner {
+    int64_t position;
+    int64_t texcoord;
+    bool relativePosition;
+    bool relativeTexcoord;
+};
+
+struct IndexPair {
+    uint32_t position;
+    uint32_t texcoord;
+};
+
+struct RangeResult {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<Corner> corners;
+    std::vector<IndexPair> pairs;
+    bool valid = true;
+};
+
+Corner makeCorner(int64_t position, int64_t texcoord, const RangeResult &range) {
+    Corner corner{};
+    corner.relativePosition = position < 0;
+    corner.position = position < 0 ? static_cast<int64_t>(range.positions.size()) + position : position - 1;
+    corner.relativeTexcoord = texcoord < 0 && texcoord != kNoTexcoord;
+    corner.texcoord = corner.relativeTexcoord ? static_cast<int64_t>(range.texcoords.size()) + texcoord
+                    : texcoord == kNoTexcoord ? kNoTexcoord : texcoord - 1;
+    return corner;
+}
+
+void parseFace(const char *p, const char *end, RangeResult &range, std::vector<Corner> &face) {
+    face.clear();
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p >= end) {
+            break;
+        }
+        int64_t position = 0;
+        int64_t texcoord = kNoTexcoord;
+        if (!parseCorner(p, end, position, texcoord)) {
+            range.valid = false;
+            return;
+        }
+        face.push_back(makeCorner(position, texcoord, range));
+    }
+    for (size_t i = 1; i + 1 < face.size(); i++) {
+        range.corners.push_back(face[0]);
+        range.corners.push_back(face[i]);
+        range.corners.push_back(face[i + 1]);
+    }
+}
+
+void parseRange(const char *p, const char *end, RangeResult &range) {
+    PROFILE_FUNCTION();
+    std::vector<Corner> face;
+    while (p < end && range.valid) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+
+        const char *line = skipSpaces(p, lineEnd);
+        if (isKeyword(line, lineEnd, "v", 1)) {
+            glm::vec3 position;
+            if (parsePosition(line + 2, lineEnd, position)) {
+                range.positions.push_back(position);
+            }
+        }
+        else if (isKeyword(line, lineEnd, "vt", 2)) {
+            glm::vec2 texcoord;
+            if (parseTexcoord(line + 3, lineEnd, texcoord)) {
+                range.texcoords.push_back(texcoord);
+            }
+        }
+        else if (isKeyword(line, lineEnd, "f", 1)) {
+            parseFace(line + 2, lineEnd, range, face);
+        }
+        p = next;
+    }
+}
+
+// Turns a range's corners into absolute attribute indices, dropping corners
+// without a texcoord.
+void resolveRange(RangeResult &range, size_t positionCount, size_t texcoordCount,
+                  int64_t positionOffset, int64_t texcoordOffset) {
+    range.pairs.reserve(range.corners.size());
+    for (const Corner &corner : range.corners) {
+        if (corner.texcoord == kNoTexcoord) {
+            continue;
+        }
+        const int64_t position = corner.relativePosition ? positionOffset + corner.position : corner.position;
+        const int64_t texcoord = corner.relativeTexcoord ? texcoordOffset + corner.texcoord : corner.texcoord;
+        if (position < 0 || position >= static_cast<int64_t>(positionCount) ||
+            texcoord < 0 || texcoord >= static_cast<int64_t>(texcoordCount)) {
+            range.valid = false;
+            return;
+        }
+        range.pairs.push_back({static_cast<uint32_t>(position), static_cast<uint32_t>(texcoord)});
+    }
+    std::vector<Corner>().swap(range.corners);
+}
+
+// Runs work(0..count-1) as jobs; the calling thread takes part.
+template <typename Work>
+void runParallel(size_t count, Work &&work) {
+    JobSystem::global().parallelFor(0, count, 1, [&work](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            work(i);
+        }
+    });
+}
+
+}
+
+std::shared_ptr<Mesh> parseObjParallel(const std::string &path, unsigned threads) {
+    PROFILE_FUNCTION();
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        return nullptr;
+    }
+    if (threads == 0) {
+        threads = JobSystem::global().threadCount();
+    }
+
+    // Split into line-aligned ranges.
+    const char *begin = file.data();
+    const char *end = begin + file.size();
+    const size_t rangeCount = std::clamp<size_t>(file.size() / kMinRangeBytes, 1, threads);
+    std::vector<const char *> bounds{begin};
+    for (size_t i = 1; i < rangeCount; i++) {
+        const char *p = std::max(begin + file.size() * i / rangeCount, bounds.back());
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        bounds.push_back(newline ? newline + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<RangeResult> ranges(rangeCount);
+    runParallel(rangeCount, [&](size_t i) { parseRange(bounds[i], bounds[i + 1], ranges[i]); });
+
+    // Attributes are concatenated in file order, which fixes every range's
+    // offset for relative indices.
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<int64_t> positionOffsets, texcoordOffsets;
+    {
+        PROFILE_SCOPE("merge attributes");
+        size_t positionCount = 0, texcoordCount = 0;
+        for (const auto &range : ranges) {
+            if (!range.valid) {
+                return nullptr;
+            }
+            positionOffsets.push_back(static_cast<int64_t>(positionCount));
+            texcoordOffsets.push_back(static_cast<int64_t>(texcoordCount));
+            positionCount += range.positions.size();
+            texcoordCount += range.texcoords.size();
+        }
+        positions.reserve(positionCount);
+        texcoords.reserve(texcoordCount);
+        for (auto &range : ranges) {
+            positions.insert(positions.end(), range.positions.begin(), range.positions.end());
+            texcoords.insert(texcoords.end(), range.texcoords.begin(), range.texcoords.end());
+            std::vector<glm::vec3>().swap(range.positions);
+            std::vector<glm::vec2>().swap(range.texcoords);
+        }
+    }
+
+    runParallel(rangeCount, [&](size_t i) {
+        resolveRange(ranges[i], positions.size(), texcoords.size(), positionOffsets[i], texcoordOffsets[i]);
+    });
+
+    PROFILE_SCOPE("deduplicate");
+    auto mesh = std::make_shared<Mesh>();
+    size_t cornerCount = 0;
+    for (const auto &range : ranges) {
+        if (!range.valid) {
+            return nullptr;
+        }
+        cornerCount += range.pairs.size();
+    }
+    mesh->indices.reserve(cornerCount);
+
+    // Equal index pairs always give equal nodes, so a pair seen before skips
+    // hashing the node. Only the first texcoord per position is remembered,
+    // which covers typical meshes; other pairs go through the node table and
+    // the result stays what plain node deduplication produces.
+    struct FirstPair {
+        uint32_t texcoord = std::numeric_limits<uint32_t>::max();
+        uint32_t node = 0;
+    };
+    LinearArena loadArena(positions.size() * kLoadArenaBytesPerPosition);
+    std::pmr::vector<FirstPair> firstPairs(positions.size(), &loadArena);
+    NodeDeduplicator deduplicator(*mesh, &loadArena);
+    deduplicator.reserve(positions.size());
+    for (auto &range : ranges) {
+        for (const IndexPair &pair : range.pairs) {
+            FirstPair &first = firstPairs[pair.position];
+            if (first.texcoord == pair.texcoord) {
+                mesh->indices.push_back(first.node);
+                continue;
+            }
+            VertexSource source;
+            source.position = positions[pair.position];
+            source.texCoord = toTextureCoord(texcoords[pair.texcoord]);
+            const uint32_t index = deduplicator.add(source);
+            if (first.texcoord == std::numeric_limits<uint32_t>::max()) {
+                first = {pair.texcoord, index};
+            }
+        }
+        std::vector<IndexPair>().swap(range.pairs);
+    }
+    return mesh;
+}
+
+std::shared_ptr<Mesh> loadObjTinyObj(const std::string &source) {
+    PROFILE_FUNCTION();
+    auto mesh = std::make_shared<Mesh>();
+    tinyobj::attrib_t attribute;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warning, error;
+
+    bool loaded = false;
+    {
+        PROFILE_SCOPE("tinyobj::LoadObj");
+        loaded = tinyobj::LoadObj(&attribute, &shapes, &materials, &warning, &error, source.c_str());
+    }
+    if (!loaded) {
+        std::cout << "loadObjTinyObj: " << warning + error << std::endl;
+        return nullptr;
+    }
+
+    PROFILE_SCOPE("deduplicate");
+    const size_t positionCount = attribute.vertices.size() / 3;
+    LinearArena loadArena(positionCount * kLoadArenaBytesPerPosition);
+    NodeDeduplicator deduplicator(*mesh, &loadArena);
+    deduplicator.reserve(positionCount);
+
+    for (const auto &shape : shapes) {
+        for (const auto &index : shape.mesh.indices) {
+            if (index.vertex_index < 0 || index.texcoord_index < 0)
+                continue;
+
+            VertexSource source;
+            source.position = {
+                attribute.vertices.at(3 * index.vertex_index + 0),
+                attribute.vertices.at(3 * index.vertex_index + 1),
+                attribute.vertices.at(3 * index.vertex_index + 2)
+            };
+
+            source.texCoord = {
+                attribute.texcoords.at(2 * index.texcoord_index + 0),
+                1.0f - attribute.texcoords.at(2 * index.texcoord_index + 1)
+            };
+
+            deduplicator.add(source);
+        }
+    }
+
+    return mesh;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef OBJ_PARSER
+#define OBJ_PARSER
+
+#include "Resource.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+// Token helpers shared by the OBJ parsers. All of them work on [p, end) and
+// advance p past what they consumed.
+namespace obj {
+
+inline const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+inline bool parseFloat(const char *&p, const char *end, float &value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+') {
+        p++;
+    }
+    const auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc()) {
+        return false;
+    }
+    p = next;
+    return true;
+}
+
+// Reads an index as written in the file: 1-based, negative counts back.
+inline bool parseRawIndex(const char *&p, const char *end, int64_t &value) {
+    const auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc() || value == 0) {
+        return false;
+    }
+    p = next;
+    return true;
+}
+
+// Turns a raw index into a 0-based one, given how many elements precede it.
+inline bool resolveIndex(int64_t value, size_t count, uint32_t &index) {
+    const int64_t resolved = value > 0 ? value - 1 : static_cast<int64_t>(count) + value;
+    if (resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+        return false;
+    }
+    index = static_cast<uint32_t>(resolved);
+    return true;
+}
+
+inline bool isKeyword(const char *p, const char *end, const char *keyword, size_t length) {
+    return static_cast<size_t>(end - p) > length && std::equal(keyword, keyword + length, p) &&
+           (p[length] == ' ' || p[length] == '\t');
+}
+
+// The rest of a "v" line: three floats, or the line is ignored.
+inline bool parsePosition(const char *p, const char *end, glm::vec3 &position) {
+    return parseFloat(p, end, position.x) && parseFloat(p, end, position.y) && parseFloat(p, end, position.z);
+}
+
+// The rest of a "vt" line: u, and v if present (0 otherwise).
+inline bool parseTexcoord(const char *p, const char *end, glm::vec2 &texcoord) {
+    texcoord = {};
+    if (!parseFloat(p, end, texcoord.x)) {
+        return false;
+    }
+    parseFloat(p, end, texcoord.y);
+    return true;
+}
+
+// Marks a face corner written without a texcoord ("1" or "1//1"). Such
+// corners are dropped after triangulation, as tinyobj-based loading did.
+inline constexpr int64_t kNoTexcoord = std::numeric_limits<int64_t>::min();
+
+// One "v", "v/vt", "v//vn" or "v/vt/vn" corner of an "f" line, raw indices;
+// normals are skipped. False on malformed input, which rejects the file.
+inline bool parseCorner(const char *&p, const char *end, int64_t &position, int64_t &texcoord) {
+    texcoord = kNoTexcoord;
+    if (!parseRawIndex(p, end, position)) {
+        return false;
+    }
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/' && !parseRawIndex(p, end, texcoord)) {
+            return false;
+        }
+        if (p < end && *p == '/') {
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+        }
+    }
+    return true;
+}
+
+// OBJ puts v = 0 at the bottom of the image, Vulkan at the top.
+inline glm::vec2 toTextureCoord(const glm::vec2 &texcoord) {
+    return {texcoord.x, 1.0f - texcoord.y};
+}
+
+}
+
+// Memory-maps an OBJ file, parses up to `threads` line-aligned ranges of it
+// as jobs (0 = one per JobSystem thread) and merges them in file order, so
+// the result does not depend on the range count. Produces the same nodes and
+// indices as the tinyobj path: polygons are fan triangulated and corners
+// without a texcoord are skipped. Returns nullptr if the file cannot be
+// mapped or references vertices that do not exist.
+std::shared_ptr<Mesh> parseObjParallel(const std::string &path, unsigned threads = 0);
+
+// Reference loader built on tinyobjloader; also the fallback for files the
+// native parser rejects.
+std::shared_ptr<Mesh> loadObjTinyObj(const std::string &path);
+
+#endif // OBJ_PARSER
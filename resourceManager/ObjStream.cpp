@@ -0,0 +1,220 @@
+#include "ObjStream.h"
+#include "ObjParser.h"
+#include "ResourceManager.h"
+#include "../core/AllocationTracker.h"
+#include "../core/Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+using namespace obj;
+
+class SectionBuilder {
+public:
+    SectionBuilder(const StreamOptions &options, const std::function<bool(Mesh &&)> &emit)
+        : m_options(options), m_emit(emit), m_deduplicator(m_section) {}
+
+    // Returns false once the consumer asked to stop or the file turned out
+    // to be malformed (see valid()).
+    bool parseLine(const char *p, const char *end) {
+        p = skipSpaces(p, end);
+        if (isKeyword(p, end, "v", 1)) {
+            glm::vec3 position;
+            if (parsePosition(p + 2, end, position)) {
+                m_positions.push_back(position);
+            }
+        }
+        else if (isKeyword(p, end, "vt", 2)) {
+            glm::vec2 texcoord;
+            if (parseTexcoord(p + 3, end, texcoord)) {
+                m_texcoords.push_back(texcoord);
+            }
+        }
+        else if (isKeyword(p, end, "f", 1)) {
+            return parseFace(p + 2, end);
+        }
+        return true;
+    }
+
+    bool flush() {
+        if (m_section.indices.empty()) {
+            return true;
+        }
+        m_section.indexCount = static_cast<uint32_t>(m_section.indices.size());
+        const bool keepGoing = m_emit(std::move(m_section));
+        m_section = Mesh{};
+        m_deduplicator.clear();
+        return keepGoing;
+    }
+
+    // False once a face had a malformed corner or an index out of range,
+    // which makes parseObjParallel reject the whole file.
+    bool valid() const { return m_valid; }
+
+private:
+    // A face corner; ones without a texcoord are kept until triangulation so
+    // the fan matches the other loaders, then dropped.
+    struct FaceCorner {
+        VertexSource source;
+        bool textured = false;
+    };
+
+    bool parseFace(const char *p, const char *end) {
+        m_face.clear();
+        while (true) {
+            p = skipSpaces(p, end);
+            if (p >= end) {
+                break;
+            }
+            int64_t position = 0, texcoord = kNoTexcoord;
+            if (!parseCorner(p, end, position, texcoord)) {
+                m_valid = false;
+                return false;
+            }
+            FaceCorner corner;
+            if (texcoord != kNoTexcoord) {
+                uint32_t positionIndex = 0, texcoordIndex = 0;
+                if (!resolveIndex(position, m_positions.size(), positionIndex) ||
+                    !resolveIndex(texcoord, m_texcoords.size(), texcoordIndex)) {
+                    m_valid = false;
+                    return false;
+                }
+                corner.source.position = m_positions[positionIndex];
+                corner.source.texCoord = toTextureCoord(m_texcoords[texcoordIndex]);
+                corner.textured = true;
+            }
+            m_face.push_back(corner);
+        }
+
+        for (size_t i = 1; i + 1 < m_face.size(); i++) {
+            for (const FaceCorner *corner : {&m_face[0], &m_face[i], &m_face[i + 1]}) {
+                if (corner->textured) {
+                    m_deduplicator.add(corner->source);
+                }
+            }
+        }
+        if (m_section.nodes.size() >= m_options.sectionVertices) {
+            return flush();
+        }
+        return true;
+    }
+
+    const StreamOptions &m_options;
+    const std::function<bool(Mesh &&)> &m_emit;
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec2> m_texcoords;
+    std::vector<FaceCorner> m_face;
+    Mesh m_section;
+    NodeDeduplicator m_deduplicator;
+    bool m_valid = true;
+};
+
+}
+
+bool parseObjStream(const std::string &path, const StreamOptions &options,
+                    const std::function<bool(Mesh &&section)> &emit) {
+    PROFILE_FUNCTION();
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    SectionBuilder builder(options, emit);
+    std::vector<char> buffer(std::max<size_t>(options.chunkBytes, 4096));
+    size_t carried = 0;
+    bool eof = false;
+    while (!eof) {
+        file.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried));
+        const size_t filled = carried + static_cast<size_t>(file.gcount());
+        eof = !file;
+
+        // Only whole lines are parsed; the tail moves to the next chunk.
+        size_t parsedEnd = filled;
+        if (!eof) {
+            while (parsedEnd > 0 && buffer[parsedEnd - 1] != '\n') {
+                parsedEnd--;
+            }
+            if (parsedEnd == 0) {
+                // A single line longer than the chunk.
+                carried = filled;
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+        }
+
+        const char *p = buffer.data();
+        const char *end = buffer.data() + parsedEnd;
+        while (p < end) {
+            const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            const char *next = lineEnd ? lineEnd + 1 : end;
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+            if (lineEnd > p && lineEnd[-1] == '\r') {
+                lineEnd--;
+            }
+            if (!builder.parseLine(p, lineEnd)) {
+                return builder.valid();
+            }
+            p = next;
+        }
+
+        carried = filled - parsedEnd;
+        std::memmove(buffer.data(), buffer.data() + parsedEnd, carried);
+    }
+    builder.flush();
+    return true;
+}
+
+MeshStream::MeshStream(const std::string &source, const StreamOptions &options)
+    : m_maxQueued(std::max<size_t>(options.maxQueuedSections, 1)),
+      m_thread(&MeshStream::run, this, source, options) {}
+
+MeshStream::~MeshStream() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancel = true;
+    }
+    m_spaceAvailable.notify_all();
+    m_thread.join();
+}
+
+void MeshStream::run(std::string source, StreamOptions options) {
+    PROFILE_THREAD("mesh stream");
+    ALLOC_SCOPE(Subsystem::Resources);
+    const bool parsed = parseObjStream(source, options, [this](Mesh &&section) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceAvailable.wait(lock, [this] { return m_cancel || m_sections.size() < m_maxQueued; });
+        if (m_cancel) {
+            return false;
+        }
+        m_sections.push_back(std::move(section));
+        return true;
+    });
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failed = !parsed;
+    m_done = true;
+}
+
+size_t MeshStream::take(std::vector<Mesh> &out, size_t maxSections) {
+    size_t taken = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (taken < maxSections && !m_sections.empty()) {
+            out.push_back(std::move(m_sections.front()));
+            m_sections.pop_front();
+            taken++;
+        }
+    }
+    if (taken) {
+        m_spaceAvailable.notify_one();
+    }
+    return taken;
+}
+
+bool MeshStream::finished() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_done && m_sections.empty();
+}
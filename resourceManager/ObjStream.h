@@ -0,0 +1,69 @@
+#ifndef OBJ_STREAM
+#define OBJ_STREAM
+
+#include "Resource.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StreamOptions {
+  // Bytes read from the file at once.
+  size_t chunkBytes = 4 << 20;
+  // A section is emitted once it has this many unique vertices.
+  uint32_t sectionVertices = 1 << 16;
+  // Parsed sections waiting for upload; the parser blocks when it is full.
+  size_t maxQueuedSections = 4;
+};
+
+// Parses an OBJ file front to back in fixed-size chunks and emits its faces
+// as independent, deduplicated sections. Faces may reference any earlier v/vt
+// line, so only those two arrays grow with the file; the chunk, the current
+// section and its dedup table are bounded by the options. Lines, corners and
+// texcoords follow the same obj:: rules as parseObjParallel, so the sections
+// together hold the triangles getMesh() would load.
+//
+// `emit` returns false to stop parsing. Returns false if the file could not
+// be opened or a face is malformed or references vertices that do not exist
+// (where getMesh() would fall back to tinyobj); sections emitted before that
+// stay emitted.
+bool parseObjStream(const std::string &path, const StreamOptions &options,
+                    const std::function<bool(Mesh &&section)> &emit);
+
+// Runs parseObjStream on a worker thread and hands finished sections to the
+// render thread through a bounded queue.
+class MeshStream {
+public:
+  MeshStream(const std::string &source, const StreamOptions &options);
+  // Stops the parser and waits for it.
+  ~MeshStream();
+
+  MeshStream(const MeshStream &) = delete;
+  MeshStream &operator=(const MeshStream &) = delete;
+
+  // Moves up to `maxSections` parsed sections to `out` without blocking.
+  size_t take(std::vector<Mesh> &out, size_t maxSections);
+  // The parser is done and every section has been taken.
+  bool finished();
+  bool failed() const { return m_failed; }
+
+private:
+  void run(std::string source, StreamOptions options);
+
+  std::mutex m_mutex;
+  std::condition_variable m_spaceAvailable;
+  std::deque<Mesh> m_sections;
+  size_t m_maxQueued;
+  bool m_done = false;
+  std::atomic<bool> m_cancel{false};
+  std::atomic<bool> m_failed{false};
+  std::thread m_thread;
+};
+
+#endif // OBJ_STREAM
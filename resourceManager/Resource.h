@@ -3,45 +3,11 @@
 
 #include <glm/glm.hpp>
 #include <ostream>
+#include <string>
 #include <vector>
 #include <array>
 #include <vulkan/vulkan_core.h>
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-
-
-#ifndef GLM_ENABLE_EXPERIMENTAL
-namespace std {
-	template<>
-    struct hash<glm::vec2> {
-        std::size_t operator()(const glm::vec2& v) const noexcept {
-            std::size_t h1 = std::hash<float>{}(v.x);
-            std::size_t h2 = std::hash<float>{}(v.y);
-            return h1 ^ (h2 << 1);
-        }
-    };
-
-    template<>
-    struct hash<glm::vec3> {
-        std::size_t operator()(const glm::vec3& v) const noexcept {
-            std::size_t h1 = std::hash<float>{}(v.x);
-            std::size_t h2 = std::hash<float>{}(v.y);
-            std::size_t h3 = std::hash<float>{}(v.z);
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
-        }
-    };
-
-    template<>
-    struct hash<glm::ivec2> {
-        std::size_t operator()(const glm::ivec2& v) const noexcept {
-            std::size_t h1 = std::hash<int>{}(v.x);
-            std::size_t h2 = std::hash<int>{}(v.y);
-            return h1 ^ (h2 << 1);
-        }
-    };
-}
-#endif
+#include "VertexLayout.h"
 
 struct Resource {
     virtual ~Resource() = default;
@@ -51,35 +17,7 @@ struct Node {
 	glm::vec3 position;
 	glm::vec3 color = {1.0f, 1.0f, 1.0f};
 	glm::vec2 textureCoord;
-	bool operator==(const Node &other) const {
-		return position == other.position && color == other.color &&
-				textureCoord == other.textureCoord;
-	}
-
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Node);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        return bindingDescription;
-    }
-
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
-
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Node, position);
-
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Node, color);
-
-        return attributeDescriptions;
-    }
+	bool operator==(const Node &other) const;
 
     friend std::ostream& operator<<(std::ostream &os, const Node &node);
     friend std::istream& operator>>(std::istream &os, const Node &node);
@@ -102,19 +40,42 @@ struct Node {
 //     return os >> node.position.x >> node.position.y >> node.position.z >> node.color.x >> node.color.y >> node.color.z >> node.textureCoord.x >> node.textureCoord.y;
 // }
 
-template <> struct std::hash<Node> {
-size_t operator()(Node const &vertex) const {
-	return (
-		(hash<glm::vec3>()(vertex.position) ^ 
-		(hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ 
-		(hash<glm::vec2>()(vertex.textureCoord) << 1
-		);
+// Locations match vert.spv: inPosition, inColor, inTexCoord.
+template <>
+struct VertexLayoutOf<Node> : VertexLayout<Node,
+	VERTEX_ATTRIBUTE(Node, position, VertexSemantic::Position),
+	VERTEX_ATTRIBUTE(Node, color, VertexSemantic::Color),
+	VERTEX_ATTRIBUTE(Node, textureCoord, VertexSemantic::TexCoord)> {};
+
+inline bool Node::operator==(const Node &other) const {
+	return VertexLayoutOf<Node>::equal(*this, other);
 }
+
+template <> struct std::hash<Node> : VertexHash<Node> {};
+
+// Lean vertex for depth and shadow passes: a third of a Node, and meshes
+// deduplicated with it merge vertices that only differed in color or UV.
+struct PositionVertex {
+	glm::vec3 position;
+	bool operator==(const PositionVertex &other) const { return position == other.position; }
 };
 
+template <>
+struct VertexLayoutOf<PositionVertex> : VertexLayout<PositionVertex,
+	VERTEX_ATTRIBUTE(PositionVertex, position, VertexSemantic::Position)> {};
+
+template <> struct std::hash<PositionVertex> : VertexHash<PositionVertex> {};
+
 struct Mesh : public Resource {
+	std::string source;
 	std::vector<Node> nodes;
 	std::vector<uint32_t> indices;
+	// Kept separately so the mesh stays drawable after its CPU copy is dropped.
+	uint32_t indexCount = 0;
+	// Streamed meshes have no geometry of their own: it arrives in sections,
+	// each uploaded and freed on the CPU as soon as it is parsed.
+	bool streamed = false;
+	std::vector<Mesh> sections;
 	VkBuffer vertexBuffer = VK_NULL_HANDLE;
 	VkBuffer indexBuffer = VK_NULL_HANDLE;
 	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
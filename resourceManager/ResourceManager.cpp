@@ -1,56 +1,633 @@
 #include "ResourceManager.h"
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
+#include "ObjParser.h"
+#include "../core/AllocationTracker.h"
+#include "../core/Hash.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+
+// One spelling per file: '\\' and '/' both separate, relative paths are
+// resolved against the working directory and symlinks are followed.
+std::string canonicalPath(const std::string &source) {
+    std::string spelled = source;
+    std::replace(spelled.begin(), spelled.end(), '\\', '/');
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(spelled, error);
+    if (error) {
+        return std::filesystem::path(spelled).lexically_normal().generic_string();
+    }
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return (error ? path.lexically_normal() : canonical).generic_string();
+}
+
+// 0 if the file cannot be read.
+uint64_t fileHashOf(const std::string &path) {
+    PROFILE_FUNCTION();
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        return 0;
+    }
+    return hash64(file.data(), file.size());
+}
+
+}
+
+ResourceManager::~ResourceManager() {
+    for (auto &[source, pending] : m_reloads) {
+        JobSystem::global().wait(pending.done);
+    }
+    for (auto &[source, pending] : m_textureLoads) {
+        JobSystem::global().wait(pending.done);
+    }
+}
 
 std::shared_ptr<Mesh> ResourceManager::getMesh(const std::string &source) {
-    if (m_cache.count(source)) {
-        return m_cache.at(source);
+    PROFILE_FUNCTION();
+    if (CacheEntry *entry = findEntry(source)) {
+        m_stats.hits++;
+        touch(*entry);
+        return entry->mesh;
+    }
+
+    const std::string key = canonicalPath(source);
+    if (CacheEntry *entry = findEntry(key)) {
+        return hit(*entry, source, m_stats.pathAliasHits);
+    }
+    const uint64_t fileHash = fileHashOf(key);
+    if (auto known = m_byFileHash.find(fileHash); fileHash && known != m_byFileHash.end()) {
+        CacheEntry &entry = m_cache.at(known->second);
+        addAlias(entry, key);
+        return hit(entry, source, m_stats.fileHashHits);
+    }
+
+    std::shared_ptr<Mesh> resource = loadMesh(key);
+    if (!resource) {
+        m_stats.misses++;
+        return nullptr;
+    }
+    // Empty meshes (e.g. files without faces) are not worth sharing by content.
+    const uint64_t geometryHash = resource->indices.empty() ? 0 : geometryHashOf(*resource);
+    if (auto known = m_byGeometryHash.find(geometryHash);
+        geometryHash && known != m_byGeometryHash.end()) {
+        CacheEntry &entry = m_cache.at(known->second);
+        addAlias(entry, key);
+        return hit(entry, source, m_stats.geometryHashHits);
+    }
+    m_stats.misses++;
+    resource->source = key;
+    resource->indexCount = static_cast<uint32_t>(resource->indices.size());
+
+    m_lru.push_front(key);
+    CacheEntry entry{resource, m_lru.begin(), cpuBytesOf(*resource), 0};
+    entry.fileHash = fileHash;
+    entry.geometryHash = geometryHash;
+    m_stats.cpuBytesResident += entry.cpuBytes;
+    CacheEntry &inserted = m_cache.emplace(key, std::move(entry)).first->second;
+    addAlias(inserted, source);
+    if (fileHash) {
+        m_byFileHash.emplace(fileHash, key);
     }
-    std::shared_ptr<Mesh> resource = loadMesh(source);
-    m_cache.emplace(source, resource);
+    if (geometryHash) {
+        m_byGeometryHash.emplace(geometryHash, key);
+    }
+    if (m_hotReload) {
+        m_watcher.watch(key);
+    }
+    trim();
     return resource;
 }
 
-std::shared_ptr<Mesh> ResourceManager::loadMesh(const std::string &source) {
-    auto mesh = std::make_shared<Mesh>();
-    std::cout << "ResourceManager::loadMesh: " << "loading mesh" << std::endl;
-    tinyobj::attrib_t attribute;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warning, error;
-
-    if (!tinyobj::LoadObj(&attribute, &shapes, &materials, &warning, &error, source.c_str())) {
-        std::cout << "ResourceManager::loadMesh: " << warning + error << std::endl;
+std::shared_ptr<Mesh> ResourceManager::streamMesh(const std::string &source,
+                                                  const StreamOptions &options) {
+    PROFILE_FUNCTION();
+    if (CacheEntry *entry = findEntry(source)) {
+        m_stats.hits++;
+        touch(*entry);
+        return entry->mesh;
+    }
+    // Streamed files are too large to hash up front; only the path is shared.
+    const std::string key = canonicalPath(source);
+    if (CacheEntry *entry = findEntry(key)) {
+        return hit(*entry, source, m_stats.pathAliasHits);
+    }
+
+    m_stats.misses++;
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(key, error)) {
+        std::cout << "ResourceManager::streamMesh: cannot open " << source << std::endl;
         return nullptr;
     }
+    auto resource = std::make_shared<Mesh>();
+    resource->source = key;
+    resource->streamed = true;
 
-    std::unordered_map<Node, uint32_t> uniqueNodes;
+    m_lru.push_front(key);
+    CacheEntry entry{resource, m_lru.begin(), 0, 0, options};
+    CacheEntry &inserted = m_cache.emplace(key, std::move(entry)).first->second;
+    addAlias(inserted, source);
+    startStream(inserted);
+    if (m_hotReload) {
+        m_watcher.watch(key);
+    }
+    return resource;
+}
 
-    for (const auto &shape : shapes) {
-        for (const auto &index : shape.mesh.indices) {
-            if (index.vertex_index < 0 || index.texcoord_index < 0)
+CacheEntry *ResourceManager::findEntry(const std::string &key) {
+    auto it = m_cache.find(key);
+    if (it == m_cache.end()) {
+        auto alias = m_aliases.find(key);
+        if (alias == m_aliases.end()) {
+            return nullptr;
+        }
+        it = m_cache.find(alias->second);
+    }
+    return it != m_cache.end() ? &it->second : nullptr;
+}
+
+void ResourceManager::addAlias(CacheEntry &entry, const std::string &alias) {
+    if (alias == entry.mesh->source || m_aliases.count(alias)) {
+        return;
+    }
+    m_aliases.emplace(alias, entry.mesh->source);
+    entry.aliases.push_back(alias);
+}
+
+namespace {
+
+template <typename Index, typename Value>
+void eraseIfPointsTo(Index &index, const Value &value, const std::string &key) {
+    auto it = index.find(value);
+    if (it != index.end() && it->second == key) {
+        index.erase(it);
+    }
+}
+
+}
+
+void ResourceManager::forgetKeys(const CacheEntry &entry) {
+    for (const auto &alias : entry.aliases) {
+        eraseIfPointsTo(m_aliases, alias, entry.mesh->source);
+    }
+    forgetHashes(entry);
+}
+
+void ResourceManager::forgetHashes(const CacheEntry &entry) {
+    eraseIfPointsTo(m_byFileHash, entry.fileHash, entry.mesh->source);
+    eraseIfPointsTo(m_byGeometryHash, entry.geometryHash, entry.mesh->source);
+}
+
+std::shared_ptr<Mesh> ResourceManager::hit(CacheEntry &entry, const std::string &source,
+                                           uint64_t &counter) {
+    m_stats.hits++;
+    counter++;
+    m_stats.bytesDeduplicated += entry.cpuBytes ? entry.cpuBytes : entry.gpuBytes;
+    addAlias(entry, source);
+    touch(entry);
+    return entry.mesh;
+}
+
+size_t ResourceManager::pollStreams(size_t maxSections) {
+    if (m_streams.empty()) {
+        return 0;
+    }
+    PROFILE_FUNCTION();
+    size_t moved = 0;
+    std::vector<Mesh> sections;
+    for (auto it = m_streams.begin(); it != m_streams.end();) {
+        MeshStream &stream = *it->second;
+        CacheEntry &entry = m_cache.at(it->first);
+        Mesh &mesh = *entry.mesh;
+        sections.clear();
+        if (moved < maxSections) {
+            moved += stream.take(sections, maxSections - moved);
+        }
+        for (auto &section : sections) {
+            mesh.sections.push_back(std::move(section));
+        }
+        if (stream.finished()) {
+            if (stream.failed()) {
+                std::cout << "ResourceManager::pollStreams: failed to stream " << it->first << std::endl;
+            }
+            entry.streamEnded = true;
+            it = m_streams.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return moved;
+}
+
+void ResourceManager::startStream(CacheEntry &entry) {
+    // Replacing a running stream cancels it.
+    m_streams[entry.mesh->source] = std::make_unique<MeshStream>(entry.mesh->source, entry.stream);
+    entry.streamEnded = false;
+}
+
+std::shared_ptr<Texture> ResourceManager::getTexture(const std::string &source) {
+    PROFILE_FUNCTION();
+    const std::string key = canonicalPath(source);
+    if (auto it = m_textures.find(key); it != m_textures.end()) {
+        return it->second.texture;
+    }
+    auto texture = std::make_shared<Texture>();
+    texture->source = key;
+    m_textures.emplace(key, TextureEntry{texture});
+    startTextureLoad(key);
+    if (m_hotReload) {
+        m_watcher.watch(key);
+    }
+    return texture;
+}
+
+void ResourceManager::startTextureLoad(const std::string &source) {
+    if (auto running = m_textureLoads.find(source); running != m_textureLoads.end()) {
+        running->second.stale = true;
+        return;
+    }
+    // Map nodes do not move, so the job can write straight into its entry.
+    PendingTexture &pending = m_textureLoads[source];
+    JobSystem::global().runBackground([source, options = m_textureOptions, &pending] {
+        PROFILE_SCOPE("texture load");
+        pending.loaded = loadTextureData(source, options, pending.result, pending.fromCache);
+    }, &pending.done);
+}
+
+size_t ResourceManager::pollTextures() {
+    if (m_textureLoads.empty() && (m_textureUploads.empty() || !m_textureUploader)) {
+        return 0;
+    }
+    PROFILE_FUNCTION();
+    size_t finished = 0;
+    // Started after the loop: inserting into m_textureLoads may rehash it.
+    std::vector<std::string> restart;
+    for (auto it = m_textureLoads.begin(); it != m_textureLoads.end();) {
+        PendingTexture &pending = it->second;
+        if (!pending.done.done()) {
+            ++it;
+            continue;
+        }
+        const std::string source = it->first;
+        const bool stale = pending.stale;
+        const bool loaded = pending.loaded;
+        const bool fromCache = pending.fromCache;
+        TextureData result = std::move(pending.result);
+        it = m_textureLoads.erase(it);
+
+        TextureEntry &entry = m_textures.at(source);
+        Texture &texture = *entry.texture;
+        if (stale) {
+            restart.push_back(source);
+            continue;
+        }
+        finished++;
+        if (!loaded) {
+            std::cout << "ResourceManager::pollTextures: failed to load " << source << std::endl;
+            // A failed reload keeps showing the previous version.
+            if (texture.state == Texture::State::Loading) {
+                texture.state = Texture::State::Failed;
+            }
+            continue;
+        }
+        m_stats.texturesLoaded++;
+        if (fromCache) {
+            m_stats.textureCacheHits++;
+        }
+        if (texture.state == Texture::State::Ready) {
+            m_stats.reloads++;
+        }
+        releaseTextureGpu(entry);
+        texture.data = std::move(result);
+        texture.state = Texture::State::Ready;
+        m_textureUploads.push_back(entry.texture);
+    }
+    for (const auto &source : restart) {
+        startTextureLoad(source);
+    }
+
+    if (m_textureUploader) {
+        for (const auto &texture : m_textureUploads) {
+            TextureEntry &entry = m_textures.at(texture->source);
+            if (texture->image) {
                 continue;
+            }
+            if (texture->data.empty()) {
+                // The CPU copy went with dropCpuAfterUpload; load it again.
+                startTextureLoad(texture->source);
+                continue;
+            }
+            entry.gpuBytes = m_textureUploader(*texture);
+            m_stats.textureBytesResident += entry.gpuBytes;
+            if (m_budget.dropCpuAfterUpload) {
+                texture->data = TextureData{};
+            }
+        }
+        m_textureUploads.clear();
+    }
+    return finished;
+}
+
+void ResourceManager::releaseTextureGpu(TextureEntry &entry) {
+    if (!entry.texture->image) {
+        return;
+    }
+    if (m_textureReleaser) {
+        m_textureReleaser(*entry.texture);
+    }
+    m_stats.textureBytesResident -= entry.gpuBytes;
+    entry.gpuBytes = 0;
+}
+
+void ResourceManager::onMeshUploaded(Mesh &mesh, size_t gpuBytes) {
+    auto it = m_cache.find(mesh.source);
+    if (it == m_cache.end() || it->second.mesh.get() != &mesh) {
+        return;
+    }
+    CacheEntry &entry = it->second;
+    m_stats.gpuBytesResident += gpuBytes;
+    entry.gpuBytes += gpuBytes;
+    if (m_budget.dropCpuAfterUpload) {
+        dropCpuCopy(entry);
+    }
+    trim();
+}
+
+bool ResourceManager::restoreCpuCopy(Mesh &mesh) {
+    auto it = m_cache.find(mesh.source);
+    if (it == m_cache.end() || it->second.mesh.get() != &mesh) {
+        return false;
+    }
+    if (mesh.streamed) {
+        if (mesh.sections.empty() && !it->second.streamEnded && !m_streams.count(mesh.source)) {
+            startStream(it->second);
+        }
+        return true;
+    }
+    CacheEntry &entry = it->second;
+    if (!entry.cpuCopyDropped) {
+        return true;
+    }
+    std::shared_ptr<Mesh> reloaded = loadMesh(mesh.source);
+    if (!reloaded) {
+        return false;
+    }
+    mesh.nodes = std::move(reloaded->nodes);
+    mesh.indices = std::move(reloaded->indices);
+    mesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+
+    entry.cpuCopyDropped = false;
+    entry.cpuBytes = cpuBytesOf(mesh);
+    m_stats.cpuBytesResident += entry.cpuBytes;
+    return true;
+}
+
+void ResourceManager::setBudget(const CacheBudget &budget) {
+    m_budget = budget;
+    trim();
+}
+
+void ResourceManager::setHotReload(bool enabled) {
+    m_hotReload = enabled;
+    for (const auto &[source, entry] : m_cache) {
+        if (enabled) {
+            m_watcher.watch(source);
+        }
+        else {
+            m_watcher.unwatch(source);
+        }
+    }
+    for (const auto &[source, entry] : m_textures) {
+        if (enabled) {
+            m_watcher.watch(source);
+        }
+        else {
+            m_watcher.unwatch(source);
+        }
+    }
+}
 
-            Node node{};
-            node.position = {
-                attribute.vertices.at(3 * index.vertex_index + 0),
-                attribute.vertices.at(3 * index.vertex_index + 1),
-                attribute.vertices.at(3 * index.vertex_index + 2)
-            };
+size_t ResourceManager::pollReloads() {
+    if (!m_hotReload && m_reloads.empty()) {
+        return 0;
+    }
+    PROFILE_FUNCTION();
+    for (const auto &source : m_watcher.poll()) {
+        auto pending = m_reloads.find(source);
+        if (pending != m_reloads.end()) {
+            pending->second.stale = true;
+        }
+        else if (auto cached = m_cache.find(source); cached != m_cache.end()) {
+            CacheEntry &entry = cached->second;
+            if (entry.mesh->streamed) {
+                releaseGpu(entry);
+                entry.mesh->sections.clear();
+                startStream(entry);
+            }
+            else {
+                startReload(source);
+            }
+        }
+        else if (m_textures.count(source)) {
+            // pollTextures() swaps the new version in.
+            startTextureLoad(source);
+        }
+    }
 
-            node.textureCoord = {
-                attribute.texcoords.at(2 * index.texcoord_index + 0),
-                1.0f - attribute.texcoords.at(2 * index.texcoord_index + 1)
-            };
+    size_t swapped = 0;
+    // Started after the loop: inserting into m_reloads may rehash it.
+    std::vector<std::string> restart;
+    for (auto it = m_reloads.begin(); it != m_reloads.end();) {
+        PendingReload &pending = it->second;
+        if (!pending.done.done()) {
+            ++it;
+            continue;
+        }
+        const std::string source = it->first;
+        const bool stale = pending.stale;
+        std::shared_ptr<Mesh> fresh = std::move(pending.result);
+        it = m_reloads.erase(it);
 
-            if (uniqueNodes.count(node) == 0) {
-                uniqueNodes[node] = static_cast<uint32_t>(mesh->nodes.size());
-                mesh->nodes.push_back(node);
+        auto cached = m_cache.find(source);
+        if (stale) {
+            // A newer version is on disk; parsing this one again is cheaper
+            // than showing a half-edited mesh for a frame.
+            if (cached != m_cache.end()) {
+                restart.push_back(source);
             }
+            continue;
+        }
+        if (!fresh) {
+            std::cout << "ResourceManager::pollReloads: keeping previous " << source << std::endl;
+            continue;
+        }
+        if (cached != m_cache.end()) {
+            swapMesh(cached->second, *fresh);
+            swapped++;
+        }
+    }
+    for (const auto &source : restart) {
+        startReload(source);
+    }
+    if (swapped) {
+        trim();
+    }
+    return swapped;
+}
+
+void ResourceManager::startReload(const std::string &source) {
+    // loadMesh touches no cache state, so it is safe to run off-thread. Map
+    // nodes do not move, so the job can write straight into its entry.
+    PendingReload &pending = m_reloads[source];
+    JobSystem::global().runBackground([this, source, &pending] {
+        PROFILE_SCOPE("mesh reload");
+        pending.result = loadMesh(source);
+    }, &pending.done);
+}
+
+void ResourceManager::swapMesh(CacheEntry &entry, Mesh &fresh) {
+    Mesh &mesh = *entry.mesh;
+    releaseGpu(entry);
+    m_stats.cpuBytesResident -= entry.cpuBytes;
+    mesh.nodes = std::move(fresh.nodes);
+    mesh.indices = std::move(fresh.indices);
+    mesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    entry.cpuCopyDropped = false;
+
+    // Meshes shared by content follow the file that was loaded; new lookups
+    // are matched against the new geometry.
+    forgetHashes(entry);
+    entry.fileHash = 0;
+    entry.geometryHash = mesh.indices.empty() ? 0 : geometryHashOf(mesh);
+    if (entry.geometryHash) {
+        m_byGeometryHash.emplace(entry.geometryHash, mesh.source);
+    }
+    entry.cpuBytes = cpuBytesOf(mesh);
+    m_stats.cpuBytesResident += entry.cpuBytes;
+    m_stats.reloads++;
+}
+
+void ResourceManager::releaseGpuResources() {
+    for (auto &[source, entry] : m_cache) {
+        releaseGpu(entry);
+    }
+    for (auto &[source, entry] : m_textures) {
+        if (entry.texture->image) {
+            releaseTextureGpu(entry);
+            // Uploaded again once there is a device to upload to.
+            m_textureUploads.push_back(entry.texture);
+        }
+    }
+}
+
+void ResourceManager::trim(std::pmr::memory_resource *scratch) {
+    PROFILE_FUNCTION();
+    // Oldest entries first. Iterators stay valid while other entries are
+    // erased, and with a frame arena as scratch the list costs no heap
+    // allocation when nothing is evicted.
+    std::pmr::vector<Cache::iterator> order(scratch);
+    order.reserve(m_lru.size());
+    for (auto key = m_lru.rbegin(); key != m_lru.rend(); ++key) {
+        order.push_back(m_cache.find(*key));
+    }
+    auto unreferenced = [](const CacheEntry &entry) { return entry.mesh.use_count() == 1; };
+
+    for (auto it : order) {
+        if (m_stats.gpuBytesResident <= m_budget.gpuBytes) {
+            break;
+        }
+        CacheEntry &entry = it->second;
+        if (entry.gpuBytes && unreferenced(entry)) {
+            releaseGpu(entry);
+        }
+    }
+
+    // Uploaded meshes can give up their CPU copy whether or not they are used.
+    for (auto it : order) {
+        if (m_stats.cpuBytesResident <= m_budget.cpuBytes) {
+            break;
+        }
+        CacheEntry &entry = it->second;
+        if (entry.gpuBytes && entry.cpuBytes) {
+            dropCpuCopy(entry);
+        }
+    }
 
-            mesh->indices.push_back(uniqueNodes[node]);
+    for (auto it : order) {
+        const std::string &key = it->first;
+        CacheEntry &entry = it->second;
+        if (!unreferenced(entry)) {
+            continue;
+        }
+        const bool empty = entry.cpuBytes == 0 && entry.gpuBytes == 0;
+        if (!empty && m_stats.cpuBytesResident <= m_budget.cpuBytes) {
+            continue;
         }
+        releaseGpu(entry);
+        m_stats.cpuBytesResident -= entry.cpuBytes;
+        m_watcher.unwatch(key);
+        m_streams.erase(key);
+        forgetKeys(entry);
+        m_lru.erase(entry.lru);
+        m_cache.erase(it);
+        m_stats.evictions++;
     }
+}
 
-    return mesh;
-}
\ No newline at end of file
+void ResourceManager::touch(CacheEntry &entry) {
+    m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+}
+
+void ResourceManager::dropCpuCopy(CacheEntry &entry) {
+    if (entry.cpuBytes == 0) {
+        return;
+    }
+    std::vector<Node>().swap(entry.mesh->nodes);
+    std::vector<uint32_t>().swap(entry.mesh->indices);
+    m_stats.cpuBytesResident -= entry.cpuBytes;
+    entry.cpuBytes = 0;
+    entry.cpuCopyDropped = true;
+    m_stats.cpuCopiesDropped++;
+}
+
+void ResourceManager::releaseGpu(CacheEntry &entry) {
+    if (entry.gpuBytes == 0) {
+        return;
+    }
+    if (m_gpuReleaser) {
+        m_gpuReleaser(*entry.mesh);
+    }
+    if (entry.mesh->streamed) {
+        // Uploaded sections kept no CPU copy, so the mesh has to be streamed
+        // again from the start; a stream still running would leave a gap.
+        m_streams.erase(entry.mesh->source);
+        entry.streamEnded = false;
+    }
+    m_stats.gpuBytesResident -= entry.gpuBytes;
+    entry.gpuBytes = 0;
+    m_stats.gpuReleases++;
+}
+
+uint64_t ResourceManager::geometryHashOf(const Mesh &mesh) {
+    static_assert(VertexLayoutOf<Node>::packed, "padding bytes would make equal meshes hash differently");
+    const uint64_t seed = hash64(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    return hash64(mesh.nodes.data(), mesh.nodes.size() * sizeof(Node), seed);
+}
+
+size_t ResourceManager::cpuBytesOf(const Mesh &mesh) {
+    return mesh.nodes.capacity() * sizeof(Node) + mesh.indices.capacity() * sizeof(uint32_t);
+}
+
+std::shared_ptr<Mesh> ResourceManager::loadMesh(const std::string &source) {
+    PROFILE_FUNCTION();
+    ALLOC_SCOPE(Subsystem::Resources);
+    if (m_objParser == ObjParser::Native) {
+        if (auto mesh = parseObjParallel(source)) {
+            return mesh;
+        }
+        std::cout << "ResourceManager::loadMesh: native parser failed, falling back to tinyobj" << std::endl;
+    }
+    return loadObjTinyObj(source);
+}
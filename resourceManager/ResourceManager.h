@@ -1,26 +1,278 @@
 #ifndef RESOURCEMANAGER
 #define RESOURCEMANAGER
 
+#include "../core/JobSystem.h"
+#include "FileWatcher.h"
+#include "ObjStream.h"
 #include "Resource.h"
+#include "Texture.h"
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <tiny_obj_loader.h>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
-using Cache = std::unordered_map<std::string, std::shared_ptr<Mesh>>;
+struct CacheEntry {
+  std::shared_ptr<Mesh> mesh;
+  std::list<std::string>::iterator lru;
+  size_t cpuBytes = 0;
+  size_t gpuBytes = 0;
+  // Reused when a streamed mesh has to be streamed again.
+  StreamOptions stream;
+  // The last stream ran to its end or failed; its sections (possibly none)
+  // are all there is until the GPU copy is released or the file reloads.
+  bool streamEnded = false;
+  // Every other key that leads to this entry, dropped on eviction.
+  std::vector<std::string> aliases;
+  uint64_t fileHash = 0;
+  uint64_t geometryHash = 0;
+  // Set only when dropCpuCopy() freed nodes/indices, so restoreCpuCopy()
+  // never re-reads a mesh whose geometry really is empty.
+  bool cpuCopyDropped = false;
+};
+
+using Cache = std::unordered_map<std::string, CacheEntry>;
+
+struct CacheBudget {
+  size_t cpuBytes = std::numeric_limits<size_t>::max();
+  size_t gpuBytes = std::numeric_limits<size_t>::max();
+  // Free nodes/indices as soon as a mesh has been uploaded.
+  bool dropCpuAfterUpload = false;
+};
+
+struct CacheStats {
+  // Each getMesh()/streamMesh() call is exactly one hit or one miss. A
+  // geometry-hash hit still parses the file but adds no entry, so it is a hit.
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  uint64_t cpuCopiesDropped = 0;
+  uint64_t gpuReleases = 0;
+  uint64_t reloads = 0;
+  // Hits that needed more than the exact path spelling: another spelling of
+  // the same file, another file with the same bytes, or another file with the
+  // same geometry after parsing.
+  uint64_t pathAliasHits = 0;
+  uint64_t fileHashHits = 0;
+  uint64_t geometryHashHits = 0;
+  // CPU bytes not loaded a second time thanks to the three above.
+  size_t bytesDeduplicated = 0;
+  size_t cpuBytesResident = 0;
+  size_t gpuBytesResident = 0;
+  uint64_t texturesLoaded = 0;
+  // Loads served in GPU-ready form from TextureOptions::cacheDirectory.
+  uint64_t textureCacheHits = 0;
+  // Textures are outside both budgets: they are never evicted.
+  size_t textureBytesResident = 0;
+};
+
+// Appends vertices to a vertex array, reusing the index of an identical
+// vertex. Hashing and comparison come from the vertex layout.
+template <typename Vertex>
+class VertexDeduplicator {
+public:
+  // The table lives in `resource`; loads pass an arena that is dropped with
+  // the table, so its buckets and nodes cost no individual frees.
+  VertexDeduplicator(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
+                     std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : m_vertices(vertices), m_indices(indices), m_unique(resource) {}
 
+  // Returns the index that was appended.
+  uint32_t add(const Vertex &vertex) {
+    auto [it, inserted] = m_unique.try_emplace(
+        vertex, static_cast<uint32_t>(m_vertices.size()));
+    if (inserted) {
+      m_vertices.push_back(vertex);
+    }
+    m_indices.push_back(it->second);
+    return it->second;
+  }
+
+  // Takes the attributes the layout declares from what a loader read.
+  uint32_t add(const VertexSource &source) { return add(VertexLayoutOf<Vertex>::fill(source)); }
+
+  // Forgets known vertices but keeps the table's buckets for the next mesh.
+  void clear() { m_unique.clear(); }
+
+  // Pre-sizes the table for about `count` unique vertices.
+  void reserve(size_t count) { m_unique.reserve(count); }
+
+private:
+  std::vector<Vertex> &m_vertices;
+  std::vector<uint32_t> &m_indices;
+  std::pmr::unordered_map<Vertex, uint32_t, VertexHash<Vertex>, VertexEqual<Vertex>> m_unique;
+};
+
+// Deduplicates into a mesh's nodes and indices.
+class NodeDeduplicator : public VertexDeduplicator<Node> {
+public:
+  explicit NodeDeduplicator(Mesh &mesh,
+                            std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : VertexDeduplicator(mesh.nodes, mesh.indices, resource) {}
+};
+
+enum class ObjParser {
+  // Memory-mapped parallel parser, falls back to tinyobj on failure.
+  Native,
+  TinyObj,
+};
+
+// Mesh cache with separate CPU and GPU byte budgets. Meshes nobody but the
+// cache references are evicted least-recently-used first; meshes still in use
+// only ever lose their CPU copy, and only once it is on the GPU.
+//
+// Entries are keyed by canonical path. A new path is checked against the
+// XXH64 of its file and, after parsing, of its geometry, so identical meshes
+// share one CPU and one GPU copy whatever they are called. Mesh::source holds
+// the canonical path of the file that was actually loaded.
 class ResourceManager {
 public:
+  using GpuReleaser = std::function<void(Mesh &)>;
+  // Creates a texture's GPU copy and returns its size in bytes.
+  using TextureUploader = std::function<size_t(Texture &)>;
+  using TextureReleaser = std::function<void(Texture &)>;
+
   ResourceManager() {}
+  explicit ResourceManager(const CacheBudget &budget) : m_budget(budget) {}
+  ~ResourceManager();
+
   std::shared_ptr<Mesh> getMesh(const std::string &source);
+  // Returns an empty streamed mesh at once and parses the file in the
+  // background; pollStreams() moves finished sections into it.
+  std::shared_ptr<Mesh> streamMesh(const std::string &source,
+                                   const StreamOptions &options = {});
+  // Moves up to `maxSections` parsed sections into Mesh::sections, where the
+  // renderer uploads them. Called once per frame on the render thread.
+  size_t pollStreams(size_t maxSections);
+  // The mesh's file is still being parsed, or its last sections have not
+  // been polled yet.
+  bool isStreaming(const Mesh &mesh) const { return m_streams.count(mesh.source) > 0; }
+  // The mesh is the one cached for its source; the cache then frees its GPU
+  // buffers. Any other mesh's buffers are the renderer's to free.
+  bool isCached(const Mesh &mesh) const {
+    auto it = m_cache.find(mesh.source);
+    return it != m_cache.end() && it->second.mesh.get() == &mesh;
+  }
+
+  // Called by the renderer after a cached mesh (or one of its sections) got
+  // GPU buffers of `gpuBytes`.
+  void onMeshUploaded(Mesh &mesh, size_t gpuBytes);
+  // Renderer hook that frees (or schedules freeing of) a mesh's GPU buffers.
+  void setGpuReleaser(GpuReleaser releaser) { m_gpuReleaser = std::move(releaser); }
+  // Hands every cached mesh's GPU buffers to the releaser, e.g. on device loss.
+  void releaseGpuResources();
+
+  // Reloads nodes/indices of a cached mesh whose CPU copy was dropped and whose
+  // GPU buffers are gone (device loss, GPU eviction); streamed meshes are
+  // streamed again. Returns false if the mesh is not cached or the reload failed.
+  bool restoreCpuCopy(Mesh &mesh);
+
+  // Returns at once, in the Loading state; the file is decoded (or read from
+  // the texture cache) by a background job. Cached by canonical path.
+  std::shared_ptr<Texture> getTexture(const std::string &source);
+  // Finishes textures whose load completed and hands every loaded texture
+  // without a GPU copy to the uploader. Called once per frame on the render
+  // thread. Returns the number of loads finished.
+  size_t pollTextures();
+  // Applies to loads started afterwards.
+  void setTextureOptions(const TextureOptions &options) { m_textureOptions = options; }
+  const TextureOptions &textureOptions() const { return m_textureOptions; }
+  // Renderer hooks; releaseGpuResources() hands textures to the releaser too.
+  void setTextureUploader(TextureUploader uploader) { m_textureUploader = std::move(uploader); }
+  void setTextureReleaser(TextureReleaser releaser) { m_textureReleaser = std::move(releaser); }
+
+  // Evicts until both budgets hold. Called on every load and once per frame;
+  // `scratch` holds the eviction order for the duration of the call.
+  void trim(std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+
+  // Watches the source file of every cached mesh. Changed files are parsed
+  // on a worker thread; pollReloads() swaps the result in.
+  void setHotReload(bool enabled);
+  bool hotReload() const { return m_hotReload; }
+  // Starts reloads for changed files and swaps in finished ones: the mesh
+  // object stays the same, its CPU data is replaced and its GPU buffers go to
+  // the releaser, so the renderer re-uploads just that mesh. Must be called at
+  // a frame boundary on the render thread. Returns the number of swaps.
+  size_t pollReloads();
+
+  void setObjParser(ObjParser parser) { m_objParser = parser; }
+  ObjParser objParser() const { return m_objParser; }
+
+  void setBudget(const CacheBudget &budget);
+  const CacheBudget &budget() const { return m_budget; }
+  const CacheStats &stats() const { return m_stats; }
 
 private:
   Cache m_cache;
+  std::list<std::string> m_lru;
+  CacheBudget m_budget;
+  CacheStats m_stats;
+  GpuReleaser m_gpuReleaser;
+  ObjParser m_objParser = ObjParser::Native;
+
+  struct PendingReload {
+    // Written by the job, read once `done` is.
+    std::shared_ptr<Mesh> result;
+    JobCounter done;
+    // The file changed again while the worker was parsing it.
+    bool stale = false;
+  };
+  bool m_hotReload = false;
+  FileWatcher m_watcher;
+  std::unordered_map<std::string, PendingReload> m_reloads;
+  std::unordered_map<std::string, std::unique_ptr<MeshStream>> m_streams;
+
+  struct TextureEntry {
+    std::shared_ptr<Texture> texture;
+    size_t gpuBytes = 0;
+  };
+  struct PendingTexture {
+    // Written by the job, read once `done` is.
+    TextureData result;
+    bool loaded = false;
+    bool fromCache = false;
+    JobCounter done;
+    // The file changed again while the job was loading it.
+    bool stale = false;
+  };
+  TextureOptions m_textureOptions;
+  TextureUploader m_textureUploader;
+  TextureReleaser m_textureReleaser;
+  std::unordered_map<std::string, TextureEntry> m_textures;
+  std::unordered_map<std::string, PendingTexture> m_textureLoads;
+  // Loaded textures waiting for the uploader.
+  std::vector<std::shared_ptr<Texture>> m_textureUploads;
+  // Path spellings and content hashes -> cache key.
+  std::unordered_map<std::string, std::string> m_aliases;
+  std::unordered_map<uint64_t, std::string> m_byFileHash;
+  std::unordered_map<uint64_t, std::string> m_byGeometryHash;
 
   std::shared_ptr<Mesh> loadMesh(const std::string &source);
+  void touch(CacheEntry &entry);
+  void dropCpuCopy(CacheEntry &entry);
+  void releaseGpu(CacheEntry &entry);
+  void startReload(const std::string &source);
+  void swapMesh(CacheEntry &entry, Mesh &fresh);
+  void startStream(CacheEntry &entry);
+  void startTextureLoad(const std::string &source);
+  void releaseTextureGpu(TextureEntry &entry);
+  // Finds an entry by any of its keys.
+  CacheEntry *findEntry(const std::string &key);
+  void addAlias(CacheEntry &entry, const std::string &alias);
+  void forgetKeys(const CacheEntry &entry);
+  void forgetHashes(const CacheEntry &entry);
+  std::shared_ptr<Mesh> hit(CacheEntry &entry, const std::string &source, uint64_t &counter);
+  static size_t cpuBytesOf(const Mesh &mesh);
+  static uint64_t geometryHashOf(const Mesh &mesh);
 };
 
 #endif // RESOURCEMANAGER
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+SceneDescription loadSceneDescription(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("loadSceneDescription: failed to open " + path);
+    }
+
+    SceneDescription scene;
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string directive;
+        if (!(stream >> directive) || directive[0] == '#') {
+            continue;
+        }
+
+        if (directive == "mesh" || directive == "stream") {
+            SceneMeshEntry entry;
+            entry.stream = directive == "stream";
+            if (!(stream >> entry.source)) {
+                throw std::runtime_error("loadSceneDescription: missing mesh path at line " +
+                                         std::to_string(lineNumber));
+            }
+            stream >> entry.entityCount >> entry.texture;
+            scene.meshes.push_back(entry);
+        }
+        else if (directive == "synthetic") {
+            if (!(stream >> scene.syntheticEntities >> scene.syntheticMeshes)) {
+                throw std::runtime_error("loadSceneDescription: synthetic expects <entities> <meshes> at line " +
+                                         std::to_string(lineNumber));
+            }
+            stream >> scene.syntheticResolution;
+        }
+        else {
+            throw std::runtime_error("loadSceneDescription: unknown directive '" + directive +
+                                     "' at line " + std::to_string(lineNumber));
+        }
+    }
+    return scene;
+}
+
+std::shared_ptr<Mesh> generateGridMesh(uint32_t resolution, const glm::vec3 &color) {
+    auto mesh = std::make_shared<Mesh>();
+    resolution = std::max(resolution, 1u);
+    const uint32_t side = resolution + 1;
+    mesh->nodes.reserve(static_cast<size_t>(side) * side);
+    mesh->indices.reserve(static_cast<size_t>(resolution) * resolution * 6);
+
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            Node node{};
+            node.textureCoord = {static_cast<float>(x) / resolution, static_cast<float>(y) / resolution};
+            node.position = {node.textureCoord.x - 0.5f, node.textureCoord.y - 0.5f, 0.0f};
+            node.color = color;
+            mesh->nodes.push_back(node);
+        }
+    }
+
+    for (uint32_t y = 0; y < resolution; y++) {
+        for (uint32_t x = 0; x < resolution; x++) {
+            const uint32_t i = y * side + x;
+            mesh->indices.insert(mesh->indices.end(), {i, i + side, i + 1, i + 1, i + side, i + side + 1});
+        }
+    }
+    return mesh;
+}
+
+namespace {
+
+// Spreads entities over a cube lattice so they do not all overlap.
+TransformElement latticeTransform(uint32_t index, uint32_t count) {
+    const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(std::max(count, 1u)))));
+    const float spacing = 2.0f / static_cast<float>(side);
+    TransformElement transform;
+    transform.position = {
+        -1.0f + spacing * (index % side + 0.5f),
+        -1.0f + spacing * ((index / side) % side + 0.5f),
+        spacing * (index / (side * side)) / 2.0f
+    };
+    transform.scale = glm::vec3(spacing * 0.9f);
+    return transform;
+}
+
+}
+
+uint32_t buildScene(const SceneDescription &scene, ResourceManager &resourceManager, World &world) {
+    uint32_t total = scene.syntheticEntities;
+    for (const auto &entry : scene.meshes) {
+        total += entry.entityCount;
+    }
+
+    uint32_t created = 0;
+    for (const auto &entry : scene.meshes) {
+        auto mesh = entry.stream ? resourceManager.streamMesh(entry.source)
+                                 : resourceManager.getMesh(entry.source);
+        if (!mesh) {
+            throw std::runtime_error("buildScene: failed to load " + entry.source);
+        }
+        // Decoded in the background; entities draw untextured until then.
+        auto texture = entry.texture.empty() ? nullptr : resourceManager.getTexture(entry.texture);
+        for (uint32_t i = 0; i < entry.entityCount; i++) {
+            const Entity id = world.createEntity();
+            world.addComponent(id, RenderElement(mesh, texture));
+            world.addComponent(id, latticeTransform(created++, total));
+        }
+    }
+
+    if (scene.syntheticEntities > 0) {
+        std::vector<std::shared_ptr<Mesh>> meshes;
+        const uint32_t meshCount = std::max(scene.syntheticMeshes, 1u);
+        meshes.reserve(meshCount);
+        for (uint32_t m = 0; m < meshCount; m++) {
+            const float hue = static_cast<float>(m) / meshCount;
+            meshes.push_back(generateGridMesh(scene.syntheticResolution, {hue, 1.0f - hue, 0.5f}));
+        }
+        for (uint32_t i = 0; i < scene.syntheticEntities; i++) {
+            const Entity id = world.createEntity();
+            world.addComponent(id, RenderElement(meshes[i % meshCount]));
+            world.addComponent(id, latticeTransform(created++, total));
+        }
+    }
+    return created;
+}
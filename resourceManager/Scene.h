@@ -0,0 +1,39 @@
+#ifndef SCENE
+#define SCENE
+
+#include "ResourceManager.h"
+#include "World.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SceneMeshEntry {
+    std::string source;
+    uint32_t entityCount = 1;
+    // Image file drawn on the mesh; empty for none.
+    std::string texture;
+    // Parsed in the background and drawn section by section while loading.
+    bool stream = false;
+};
+
+// Plain-text scene description, one directive per line:
+//   mesh <path> <entities> [texture]            entities sharing an OBJ mesh
+//   stream <path> <entities> [texture]          same, streamed (large OBJ files)
+//   synthetic <entities> <meshes> [resolution]  generated grid meshes
+// Lines starting with '#' are comments.
+struct SceneDescription {
+    std::vector<SceneMeshEntry> meshes;
+    uint32_t syntheticEntities = 0;
+    uint32_t syntheticMeshes = 0;
+    uint32_t syntheticResolution = 8;
+};
+
+SceneDescription loadSceneDescription(const std::string &path);
+
+// Generates a flat (resolution x resolution) quad grid, used for synthetic scenes.
+std::shared_ptr<Mesh> generateGridMesh(uint32_t resolution, const glm::vec3 &color);
+
+// Populates the world, returns the number of entities created.
+uint32_t buildScene(const SceneDescription &scene, ResourceManager &resourceManager, World &world);
+
+#endif // SCENE
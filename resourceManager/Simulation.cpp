@@ -0,0 +1,140 @@
+#include "Simulation.h"
+#include "../core/AllocationTracker.h"
+#include "../core/JobSystem.h"
+#include "../core/Profiler.h"
+#include <algorithm>
+
+namespace {
+
+// Instances per job when building a snapshot.
+constexpr size_t kSnapshotGrain = 4096;
+// Ticks run back to back after a stall before the simulation gives up on
+// catching up and drops the rest.
+constexpr int kMaxCatchUpTicks = 5;
+
+const std::shared_ptr<Mesh> kNoMesh;
+const std::shared_ptr<Texture> kNoTexture;
+
+TransformState stateOf(const TransformElement &transform) {
+    return {transform.position, transform.rotation, transform.scale};
+}
+
+}
+
+TransformState TransformState::lerp(const TransformState &a, const TransformState &b, float t) {
+    return {glm::mix(a.position, b.position, t), glm::mix(a.rotation, b.rotation, t),
+            glm::mix(a.scale, b.scale, t)};
+}
+
+glm::mat4 TransformState::modelMatrix() const {
+    TransformElement transform;
+    transform.position = position;
+    transform.rotation = rotation;
+    transform.scale = scale;
+    return transform.modelMatrix();
+}
+
+float RenderSnapshot::alpha(std::chrono::steady_clock::time_point now) const {
+    if (tickDuration.count() <= 0) {
+        return 1.0f;
+    }
+    const double t = std::chrono::duration<double>(now - time) / tickDuration;
+    return static_cast<float>(std::clamp(t, 0.0, 1.0));
+}
+
+Simulation::Simulation(World *world, double ticksPerSecond)
+    : m_world(world),
+      m_tickDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(1.0 / ticksPerSecond))) {}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running()) {
+        return;
+    }
+    m_stop.store(false);
+    m_thread = std::thread([this] { run(); });
+}
+
+void Simulation::stop() {
+    if (!running()) {
+        return;
+    }
+    m_stop.store(true);
+    m_thread.join();
+}
+
+void Simulation::step() {
+    tick(std::chrono::steady_clock::now());
+}
+
+void Simulation::run() {
+    PROFILE_THREAD("simulation");
+    auto next = std::chrono::steady_clock::now();
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - next > kMaxCatchUpTicks * m_tickDuration) {
+            next = now;
+        }
+        while (next <= now && !m_stop.load(std::memory_order_relaxed)) {
+            tick(next);
+            next += m_tickDuration;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void Simulation::tick(std::chrono::steady_clock::time_point time) {
+    PROFILE_FUNCTION();
+    ALLOC_SCOPE(Subsystem::Simulation);
+    m_tick++;
+    if (m_update) {
+        PROFILE_SCOPE("update");
+        m_update(*m_world, std::chrono::duration<double>(m_tickDuration).count());
+    }
+    RenderSnapshot &snapshot = m_snapshots.back();
+    snapshot.tick = m_tick;
+    snapshot.time = time;
+    snapshot.tickDuration = m_tickDuration;
+    buildSnapshot(snapshot);
+    m_snapshots.publish();
+}
+
+void Simulation::buildSnapshot(RenderSnapshot &snapshot) {
+    PROFILE_FUNCTION();
+    const auto &renders = m_world->storage<RenderElement>();
+    const auto &transforms = m_world->storage<TransformElement>();
+    snapshot.instances.resize(renders.size());
+    m_previous.resize(m_world->nextId());
+
+    JobSystem::global().parallelFor(0, renders.size(), kSnapshotGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            RenderInstance &instance = snapshot.instances[i];
+            const Entity entity = renders.entities()[i];
+            const TransformElement *transform = transforms.get(entity);
+            const std::shared_ptr<Mesh> &mesh = transform ? renders.components()[i].mesh : kNoMesh;
+            const std::shared_ptr<Texture> &texture = transform ? renders.components()[i].texture : kNoTexture;
+            // The slot usually holds these handles from three ticks ago;
+            // skipping the assignment saves two atomic reference count updates.
+            if (instance.mesh != mesh) {
+                instance.mesh = mesh;
+            }
+            if (instance.texture != texture) {
+                instance.texture = texture;
+            }
+            if (!transform) {
+                continue;
+            }
+            PreviousTransform &previous = m_previous[entity];
+            instance.current = stateOf(*transform);
+            // Entities that did not exist last tick start where they are.
+            const bool seenLastTick = previous.tick != 0 && previous.tick + 1 == m_tick;
+            instance.previous = seenLastTick ? previous.state : instance.current;
+            previous.state = instance.current;
+            previous.tick = m_tick;
+        }
+    });
+}
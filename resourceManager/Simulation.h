@@ -0,0 +1,100 @@
+#ifndef SIMULATION
+#define SIMULATION
+
+#include "../core/TripleBuffer.h"
+#include "World.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct TransformState {
+    glm::vec3 position{0.0f};
+    glm::vec3 rotation{0.0f};
+    glm::vec3 scale{1.0f};
+
+    // Componentwise, euler angles included: ticks are short enough for the
+    // difference to stay small.
+    static TransformState lerp(const TransformState &a, const TransformState &b, float t);
+    glm::mat4 modelMatrix() const;
+};
+
+struct RenderInstance {
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> texture;
+    // Transform at the previous and at this tick; the renderer blends them.
+    TransformState previous;
+    TransformState current;
+};
+
+// What the renderer needs from one simulation tick. Owned by the simulation
+// and read-only on the render thread.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    // steady_clock time the tick stands for.
+    std::chrono::steady_clock::time_point time{};
+    std::chrono::nanoseconds tickDuration{0};
+    std::vector<RenderInstance> instances;
+
+    // How far a frame drawn at `now` is from `previous` (0) to `current` (1).
+    // Frames are drawn one tick behind the simulation, so they can always
+    // interpolate instead of extrapolate.
+    float alpha(std::chrono::steady_clock::time_point now) const;
+};
+
+// Runs World updates on its own thread at a fixed tick rate and publishes a
+// RenderSnapshot after every tick. Once started, the World belongs to the
+// simulation thread: the renderer reads only snapshots, and neither side
+// waits for the other. Mesh loading stays on the render thread; the
+// simulation only copies mesh handles.
+class Simulation {
+public:
+    // Game logic, called once per tick with the tick length in seconds.
+    using Update = std::function<void(World &, double)>;
+
+    explicit Simulation(World *world, double ticksPerSecond = 60.0);
+    ~Simulation();
+
+    Simulation(const Simulation &) = delete;
+    Simulation &operator=(const Simulation &) = delete;
+
+    // Must be set before start().
+    void setUpdate(Update update) { m_update = std::move(update); }
+    void start();
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+    // Runs one tick on the calling thread. Only while stopped.
+    void step();
+
+    // Render thread: the newest snapshot, valid until the next call.
+    const RenderSnapshot &acquireSnapshot() { return m_snapshots.acquire(); }
+    // Render thread: the snapshot the last acquireSnapshot() returned.
+    const RenderSnapshot &currentSnapshot() const { return m_snapshots.front(); }
+
+    std::chrono::nanoseconds tickDuration() const { return m_tickDuration; }
+
+private:
+    void run();
+    void tick(std::chrono::steady_clock::time_point time);
+    void buildSnapshot(RenderSnapshot &snapshot);
+
+    struct PreviousTransform {
+        TransformState state;
+        uint64_t tick = 0;
+    };
+
+    World *m_world = nullptr;
+    std::chrono::nanoseconds m_tickDuration;
+    Update m_update;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    uint64_t m_tick = 0;
+    TripleBuffer<RenderSnapshot> m_snapshots;
+    // Indexed by entity.
+    std::vector<PreviousTransform> m_previous;
+};
+
+#endif // SIMULATION
@@ -0,0 +1,415 @@
+#include "Texture.h"
+#include "../core/Hash.h"
+#include "../core/JobSystem.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#include <QImage>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// Bump when the cache layout or the encoders change; old entries are then
+// simply never looked up again.
+constexpr uint32_t kTextureCacheVersion = 1;
+constexpr char kTextureCacheMagic[4] = {'S', 'G', 'E', 'T'};
+
+struct TextureCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t contentHash;
+    uint32_t format;
+    uint32_t mipCount;
+    uint64_t byteCount;
+};
+
+static_assert(sizeof(TextureCacheHeader) == 32);
+static_assert(sizeof(TextureMip) == 24, "TextureMip is stored as raw bytes");
+
+// Mip rows and BC1 block rows per job.
+constexpr size_t kRowGrain = 64;
+constexpr size_t kBlockRowGrain = 16;
+
+struct SrgbTables {
+    std::array<float, 256> toLinear;
+    // Linear values quantized to 12 bits.
+    std::array<uint8_t, 4096> fromLinear;
+
+    SrgbTables() {
+        for (int i = 0; i < 256; i++) {
+            const float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; i++) {
+            const float c = i / 4095.0f;
+            const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            fromLinear[i] = static_cast<uint8_t>(std::clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+};
+
+const SrgbTables &srgbTables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+void downsample(const uint8_t *source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t *target,
+                uint32_t width, uint32_t height) {
+    const SrgbTables &srgb = srgbTables();
+    JobSystem::global().parallelFor(0, height, kRowGrain, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            // Odd sizes fold the last row and column into the previous pixel.
+            const uint32_t y0 = static_cast<uint32_t>(y) * 2;
+            const uint32_t y1 = std::min(y0 + 1, sourceHeight - 1);
+            for (uint32_t x = 0; x < width; x++) {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, sourceWidth - 1);
+                const uint8_t *p[4] = {
+                    source + (size_t(y0) * sourceWidth + x0) * 4, source + (size_t(y0) * sourceWidth + x1) * 4,
+                    source + (size_t(y1) * sourceWidth + x0) * 4, source + (size_t(y1) * sourceWidth + x1) * 4,
+                };
+                uint8_t *out = target + (y * width + x) * 4;
+                for (int c = 0; c < 3; c++) {
+                    const float linear = (srgb.toLinear[p[0][c]] + srgb.toLinear[p[1][c]] +
+                                          srgb.toLinear[p[2][c]] + srgb.toLinear[p[3][c]]) * 0.25f;
+                    out[c] = srgb.fromLinear[static_cast<size_t>(linear * 4095.0f + 0.5f)];
+                }
+                out[3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+            }
+        }
+    });
+}
+
+uint16_t packRgb565(const uint8_t *rgb) {
+    return static_cast<uint16_t>(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 |
+                                 ((rgb[2] * 31 + 127) / 255));
+}
+
+std::array<int, 3> unpackRgb565(uint16_t color) {
+    const int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// Range fit: endpoints from the block's (slightly inset) bounding box, every
+// pixel snapped to the nearest palette entry. Blocks with transparent pixels
+// use the three-color mode, whose fourth entry is transparent black.
+void encodeBC1Block(const uint8_t (&pixels)[16][4], uint8_t *block) {
+    uint8_t low[3] = {255, 255, 255}, high[3] = {0, 0, 0};
+    bool transparent = false, opaque = false;
+    for (const auto &pixel : pixels) {
+        if (pixel[3] < 128) {
+            transparent = true;
+            continue;
+        }
+        opaque = true;
+        for (int c = 0; c < 3; c++) {
+            low[c] = std::min(low[c], pixel[c]);
+            high[c] = std::max(high[c], pixel[c]);
+        }
+    }
+    if (!opaque) {
+        low[0] = low[1] = low[2] = high[0] = high[1] = high[2] = 0;
+    }
+    for (int c = 0; c < 3; c++) {
+        const int inset = (high[c] - low[c]) / 16;
+        low[c] = static_cast<uint8_t>(low[c] + inset);
+        high[c] = static_cast<uint8_t>(high[c] - inset);
+    }
+
+    uint16_t color0 = packRgb565(high), color1 = packRgb565(low);
+    std::array<std::array<int, 3>, 4> palette{};
+    int entries = 4;
+    if (transparent) {
+        // color0 <= color1 selects the three-color mode.
+        std::swap(color0, color1);
+        palette[0] = unpackRgb565(color0);
+        palette[1] = unpackRgb565(color1);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        entries = 3;
+    }
+    else if (color0 == color1) {
+        entries = 1;
+        palette[0] = unpackRgb565(color0);
+    }
+    else {
+        palette[0] = unpackRgb565(color0);
+        palette[1] = unpackRgb565(color1);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++) {
+        uint32_t index = 3;
+        if (!transparent || pixels[i][3] >= 128) {
+            int best = std::numeric_limits<int>::max();
+            for (int e = 0; e < entries; e++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    const int d = pixels[i][c] - palette[e][c];
+                    distance += d * d;
+                }
+                if (distance < best) {
+                    best = distance;
+                    index = static_cast<uint32_t>(e);
+                }
+            }
+        }
+        indices |= index << (2 * i);
+    }
+    std::memcpy(block, &color0, 2);
+    std::memcpy(block + 2, &color1, 2);
+    std::memcpy(block + 4, &indices, 4);
+}
+
+// Standard BC1 decode: color0 > color1 selects four opaque colors, otherwise
+// three colors and transparent black.
+void decodeBC1Block(const uint8_t *block, uint8_t (&pixels)[16][4]) {
+    uint16_t color0, color1;
+    uint32_t indices;
+    std::memcpy(&color0, block, 2);
+    std::memcpy(&color1, block + 2, 2);
+    std::memcpy(&indices, block + 4, 4);
+
+    std::array<std::array<int, 4>, 4> palette{};
+    const auto rgb0 = unpackRgb565(color0), rgb1 = unpackRgb565(color1);
+    for (int c = 0; c < 3; c++) {
+        palette[0][c] = rgb0[c];
+        palette[1][c] = rgb1[c];
+        if (color0 > color1) {
+            palette[2][c] = (2 * rgb0[c] + rgb1[c]) / 3;
+            palette[3][c] = (rgb0[c] + 2 * rgb1[c]) / 3;
+        }
+        else {
+            palette[2][c] = (rgb0[c] + rgb1[c]) / 2;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = color0 > color1 ? 255 : 0;
+
+    for (int i = 0; i < 16; i++) {
+        const auto &color = palette[(indices >> (2 * i)) & 3];
+        for (int c = 0; c < 4; c++) {
+            pixels[i][c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+uint64_t contentHashOf(const MappedFile &file, const TextureOptions &options) {
+    // The same image loaded with other options is another cache entry.
+    const uint64_t seed = uint64_t(kTextureCacheVersion) << 8 | uint64_t(options.generateMips) << 1 |
+                          uint64_t(options.compress);
+    return hash64(file.data(), file.size(), seed);
+}
+
+std::filesystem::path cachePathOf(const std::string &directory, uint64_t contentHash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tex", static_cast<unsigned long long>(contentHash));
+    return std::filesystem::path(directory) / name;
+}
+
+bool readTextureCache(const std::filesystem::path &path, uint64_t contentHash, TextureData &data) {
+    PROFILE_FUNCTION();
+    MappedFile file(path.string());
+    if (!file.isOpen() || file.size() < sizeof(TextureCacheHeader)) {
+        return false;
+    }
+    TextureCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kTextureCacheMagic, 4) != 0 || header.version != kTextureCacheVersion ||
+        header.contentHash != contentHash || header.format > uint32_t(TextureFormat::BC1)) {
+        return false;
+    }
+    const uint64_t mipBytes = uint64_t(header.mipCount) * sizeof(TextureMip);
+    if (mipBytes > file.size() - sizeof(header) ||
+        header.byteCount != file.size() - sizeof(header) - mipBytes) {
+        return false;
+    }
+    data.format = static_cast<TextureFormat>(header.format);
+    data.mips.resize(header.mipCount);
+    std::memcpy(data.mips.data(), file.data() + sizeof(header), mipBytes);
+    for (const TextureMip &mip : data.mips) {
+        if (mip.offset > header.byteCount || mip.size > header.byteCount - mip.offset) {
+            return false;
+        }
+    }
+    const char *bytes = file.data() + sizeof(header) + mipBytes;
+    data.bytes.assign(bytes, bytes + header.byteCount);
+    return true;
+}
+
+void writeTextureCache(const std::filesystem::path &path, uint64_t contentHash, const TextureData &data) {
+    PROFILE_FUNCTION();
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    // Written aside and renamed, so a reader never maps half a file.
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        TextureCacheHeader header{};
+        std::memcpy(header.magic, kTextureCacheMagic, 4);
+        header.version = kTextureCacheVersion;
+        header.contentHash = contentHash;
+        header.format = static_cast<uint32_t>(data.format);
+        header.mipCount = static_cast<uint32_t>(data.mips.size());
+        header.byteCount = data.bytes.size();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(data.mips.data()),
+                   static_cast<std::streamsize>(data.mips.size() * sizeof(TextureMip)));
+        file.write(reinterpret_cast<const char *>(data.bytes.data()),
+                   static_cast<std::streamsize>(data.bytes.size()));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+}
+
+TextureData buildTextureMips(const uint8_t *rgba, uint32_t width, uint32_t height, bool generateMips) {
+    PROFILE_FUNCTION();
+    TextureData data;
+    data.format = TextureFormat::RGBA8;
+    uint64_t offset = 0;
+    for (uint32_t w = width, h = height;; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+        const uint64_t size = uint64_t(w) * h * 4;
+        data.mips.push_back({w, h, offset, size});
+        offset += size;
+        if (!generateMips || (w == 1 && h == 1)) {
+            break;
+        }
+    }
+    data.bytes.resize(offset);
+    std::memcpy(data.bytes.data(), rgba, data.mips[0].size);
+    for (size_t level = 1; level < data.mips.size(); level++) {
+        const TextureMip &source = data.mips[level - 1];
+        const TextureMip &target = data.mips[level];
+        downsample(data.bytes.data() + source.offset, source.width, source.height,
+                   data.bytes.data() + target.offset, target.width, target.height);
+    }
+    return data;
+}
+
+TextureData compressBC1(const TextureData &rgba) {
+    PROFILE_FUNCTION();
+    TextureData data;
+    data.format = TextureFormat::BC1;
+    uint64_t offset = 0;
+    for (const TextureMip &mip : rgba.mips) {
+        const uint64_t size = uint64_t((mip.width + 3) / 4) * ((mip.height + 3) / 4) * 8;
+        data.mips.push_back({mip.width, mip.height, offset, size});
+        offset += size;
+    }
+    data.bytes.resize(offset);
+    for (size_t level = 0; level < rgba.mips.size(); level++) {
+        const TextureMip &source = rgba.mips[level];
+        const uint8_t *pixels = rgba.bytes.data() + source.offset;
+        uint8_t *blocks = data.bytes.data() + data.mips[level].offset;
+        const uint32_t blocksWide = (source.width + 3) / 4;
+        const uint32_t blocksHigh = (source.height + 3) / 4;
+        JobSystem::global().parallelFor(0, blocksHigh, kBlockRowGrain, [&](size_t begin, size_t end) {
+            uint8_t block[16][4];
+            for (size_t by = begin; by < end; by++) {
+                for (uint32_t bx = 0; bx < blocksWide; bx++) {
+                    // Edge blocks repeat the last row and column.
+                    for (uint32_t i = 0; i < 16; i++) {
+                        const uint32_t x = std::min(bx * 4 + i % 4, source.width - 1);
+                        const uint32_t y = std::min(static_cast<uint32_t>(by) * 4 + i / 4, source.height - 1);
+                        std::memcpy(block[i], pixels + (size_t(y) * source.width + x) * 4, 4);
+                    }
+                    encodeBC1Block(block, blocks + (by * blocksWide + bx) * 8);
+                }
+            }
+        });
+    }
+    return data;
+}
+
+TextureData decompressBC1(const TextureData &bc1) {
+    PROFILE_FUNCTION();
+    TextureData data;
+    data.format = TextureFormat::RGBA8;
+    uint64_t offset = 0;
+    for (const TextureMip &mip : bc1.mips) {
+        const uint64_t size = uint64_t(mip.width) * mip.height * 4;
+        data.mips.push_back({mip.width, mip.height, offset, size});
+        offset += size;
+    }
+    data.bytes.resize(offset);
+    for (size_t level = 0; level < bc1.mips.size(); level++) {
+        const TextureMip &target = data.mips[level];
+        const uint8_t *blocks = bc1.bytes.data() + bc1.mips[level].offset;
+        uint8_t *pixels = data.bytes.data() + target.offset;
+        const uint32_t blocksWide = (target.width + 3) / 4;
+        const uint32_t blocksHigh = (target.height + 3) / 4;
+        JobSystem::global().parallelFor(0, blocksHigh, kBlockRowGrain, [&](size_t begin, size_t end) {
+            uint8_t block[16][4];
+            for (size_t by = begin; by < end; by++) {
+                for (uint32_t bx = 0; bx < blocksWide; bx++) {
+                    decodeBC1Block(blocks + (by * blocksWide + bx) * 8, block);
+                    // Edge blocks cover pixels past the image; those are skipped.
+                    for (uint32_t i = 0; i < 16; i++) {
+                        const uint32_t x = bx * 4 + i % 4;
+                        const uint32_t y = static_cast<uint32_t>(by) * 4 + i / 4;
+                        if (x < target.width && y < target.height) {
+                            std::memcpy(pixels + (size_t(y) * target.width + x) * 4, block[i], 4);
+                        }
+                    }
+                }
+            }
+        });
+    }
+    return data;
+}
+
+bool loadTextureData(const std::string &path, const TextureOptions &options, TextureData &data,
+                     bool &fromCache) {
+    PROFILE_FUNCTION();
+    fromCache = false;
+    MappedFile file(path);
+    if (!file.isOpen() || file.size() == 0) {
+        return false;
+    }
+    const uint64_t contentHash = contentHashOf(file, options);
+    if (!options.cacheDirectory.empty() &&
+        readTextureCache(cachePathOf(options.cacheDirectory, contentHash), contentHash, data)) {
+        fromCache = true;
+        return true;
+    }
+
+    QImage image;
+    {
+        PROFILE_SCOPE("decode");
+        if (!image.loadFromData(reinterpret_cast<const uchar *>(file.data()), static_cast<int>(file.size()))) {
+            return false;
+        }
+        image = image.convertToFormat(QImage::Format_RGBA8888);
+    }
+    const auto width = static_cast<uint32_t>(image.width());
+    const auto height = static_cast<uint32_t>(image.height());
+    // RGBA8888 rows are whole 32-bit words, so scan lines are already tight.
+    data = buildTextureMips(image.constBits(), width, height, options.generateMips);
+    if (options.compress) {
+        data = compressBC1(data);
+    }
+    if (!options.cacheDirectory.empty()) {
+        writeTextureCache(cachePathOf(options.cacheDirectory, contentHash), contentHash, data);
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef TEXTURE
+#define TEXTURE
+
+#include "Resource.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+enum class TextureFormat : uint32_t {
+    // sRGB, four bytes per pixel.
+    RGBA8,
+    // sRGB, 8 bytes per 4x4 block with 1-bit alpha; an eighth of RGBA8.
+    BC1,
+};
+
+struct TextureMip {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Byte range in TextureData::bytes.
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+// A texture in the form the GPU takes it: every mip level, already encoded,
+// back to back in one buffer that is copied to staging as is.
+struct TextureData {
+    TextureFormat format = TextureFormat::RGBA8;
+    std::vector<TextureMip> mips;
+    std::vector<uint8_t> bytes;
+
+    bool empty() const { return mips.empty(); }
+};
+
+struct TextureOptions {
+    bool generateMips = true;
+    // BC1-compress on load; alpha is cut to 1 bit. Devices without
+    // textureCompressionBC get the blocks decoded back to RGBA8 on upload.
+    bool compress = false;
+    // Where GPU-ready forms are cached by content hash; empty disables the
+    // cache. A cached texture loads without decoding, mipping or compressing.
+    std::string cacheDirectory;
+};
+
+// Reads, decodes (QImage), mips and compresses an image file, going through
+// the cache when options.cacheDirectory is set. Runs on any thread. Returns
+// false if the file cannot be read or decoded; `fromCache` reports a cache hit.
+bool loadTextureData(const std::string &path, const TextureOptions &options, TextureData &data,
+                     bool &fromCache);
+
+// Builds every mip level of RGBA8 pixels with a box filter in linear space.
+TextureData buildTextureMips(const uint8_t *rgba, uint32_t width, uint32_t height, bool generateMips);
+// Re-encodes RGBA8 mip levels as BC1 blocks.
+TextureData compressBC1(const TextureData &rgba);
+// Decodes BC1 mip levels back to RGBA8, for devices without BC support.
+TextureData decompressBC1(const TextureData &bc1);
+
+constexpr uint32_t kNoTextureSlot = std::numeric_limits<uint32_t>::max();
+
+struct Texture : public Resource {
+    enum class State {
+        Loading,
+        Ready,
+        Failed,
+    };
+
+    std::string source;
+    State state = State::Loading;
+    // Kept after upload unless CacheBudget::dropCpuAfterUpload is set.
+    TextureData data;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    // Index into the renderer's texture array, passed to shaders as a push
+    // constant. kNoTextureSlot until uploaded.
+    uint32_t slot = kNoTextureSlot;
+};
+
+#endif // TEXTURE
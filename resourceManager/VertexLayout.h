@@ -0,0 +1,198 @@
+#ifndef VERTEX_LAYOUT
+#define VERTEX_LAYOUT
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <vulkan/vulkan_core.h>
+
+// Compile-time vertex layouts. A vertex type lists its attributes once, in
+// shader location order, by specializing VertexLayoutOf:
+//
+//   template <>
+//   struct VertexLayoutOf<MyVertex>
+//       : VertexLayout<MyVertex, VERTEX_ATTRIBUTE(MyVertex, position, VertexSemantic::Position)> {};
+//
+// and gets from it the Vulkan binding and attribute descriptions, hashing and
+// equality for deduplication, and fill(), which builds the vertex from what a
+// loader read. Everything unrolls at compile time; a layout without an
+// attribute costs nothing for it.
+
+// What an attribute means to loaders; fill() copies by meaning, not by name.
+enum class VertexSemantic {
+    Position,
+    Color,
+    TexCoord,
+};
+
+// Everything a loader knows about one vertex. Layouts take what they declare.
+struct VertexSource {
+    glm::vec3 position{0.0f};
+    glm::vec3 color{1.0f};
+    glm::vec2 texCoord{0.0f};
+};
+
+template <typename T>
+struct VertexFormat;
+
+template <>
+struct VertexFormat<float> {
+    static constexpr VkFormat value = VK_FORMAT_R32_SFLOAT;
+};
+
+template <>
+struct VertexFormat<glm::vec2> {
+    static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT;
+};
+
+template <>
+struct VertexFormat<glm::vec3> {
+    static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT;
+};
+
+template <>
+struct VertexFormat<glm::vec4> {
+    static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT;
+};
+
+namespace vertex_detail {
+
+template <typename Member>
+struct MemberTraits;
+
+template <typename Class, typename Type>
+struct MemberTraits<Type Class::*> {
+    using Vertex = Class;
+    using Value = Type;
+};
+
+inline void hashCombine(size_t &seed, size_t hash) {
+    seed ^= hash + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+template <typename T>
+size_t hashValue(const T &value) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return std::hash<T>{}(value);
+    } else {
+        size_t seed = 0;
+        for (int i = 0; i < T::length(); i++) {
+            hashCombine(seed, std::hash<typename T::value_type>{}(value[i]));
+        }
+        return seed;
+    }
+}
+
+}
+
+// One attribute: the member it reads, its byte offset (offsetof cannot be
+// taken from a member pointer in a constant expression, hence the macro) and
+// its meaning.
+template <auto Field, size_t Offset, VertexSemantic Semantic>
+struct VertexAttribute {
+    using Vertex = typename vertex_detail::MemberTraits<decltype(Field)>::Vertex;
+    using Value = typename vertex_detail::MemberTraits<decltype(Field)>::Value;
+
+    static constexpr size_t offset = Offset;
+    static constexpr VertexSemantic semantic = Semantic;
+    static constexpr VkFormat format = VertexFormat<Value>::value;
+
+    static const Value &get(const Vertex &vertex) { return vertex.*Field; }
+
+    static void fill(Vertex &vertex, const VertexSource &source) {
+        if constexpr (Semantic == VertexSemantic::Position) {
+            vertex.*Field = source.position;
+        } else if constexpr (Semantic == VertexSemantic::Color) {
+            vertex.*Field = source.color;
+        } else if constexpr (Semantic == VertexSemantic::TexCoord) {
+            vertex.*Field = source.texCoord;
+        }
+    }
+
+    static void store(const Vertex &vertex, VertexSource &source) {
+        if constexpr (Semantic == VertexSemantic::Position) {
+            source.position = vertex.*Field;
+        } else if constexpr (Semantic == VertexSemantic::Color) {
+            source.color = vertex.*Field;
+        } else if constexpr (Semantic == VertexSemantic::TexCoord) {
+            source.texCoord = vertex.*Field;
+        }
+    }
+};
+
+#define VERTEX_ATTRIBUTE(Vertex, field, semantic) \
+    VertexAttribute<&Vertex::field, offsetof(Vertex, field), semantic>
+
+template <typename VertexType, typename... Attributes>
+struct VertexLayout {
+    using Vertex = VertexType;
+
+    static constexpr uint32_t attributeCount = sizeof...(Attributes);
+    // True when the attributes cover every byte of the vertex, so its bytes
+    // can be hashed or written out directly.
+    static constexpr bool packed = (sizeof(typename Attributes::Value) + ... + 0) == sizeof(Vertex);
+
+    static_assert((std::is_same_v<typename Attributes::Vertex, Vertex> && ...),
+                  "attributes must belong to the vertex type");
+
+    template <VertexSemantic Semantic>
+    static constexpr bool has = ((Attributes::semantic == Semantic) || ...);
+
+    static constexpr VkVertexInputBindingDescription bindingDescription(uint32_t binding = 0) {
+        return {binding, static_cast<uint32_t>(sizeof(Vertex)), VK_VERTEX_INPUT_RATE_VERTEX};
+    }
+
+    // Locations are numbered in declaration order.
+    static constexpr std::array<VkVertexInputAttributeDescription, attributeCount>
+    attributeDescriptions(uint32_t binding = 0) {
+        uint32_t location = 0;
+        return {VkVertexInputAttributeDescription{location++, binding, Attributes::format,
+                                                  static_cast<uint32_t>(Attributes::offset)}...};
+    }
+
+    static Vertex fill(const VertexSource &source) {
+        Vertex vertex{};
+        (Attributes::fill(vertex, source), ...);
+        return vertex;
+    }
+
+    static VertexSource source(const Vertex &vertex) {
+        VertexSource result;
+        (Attributes::store(vertex, result), ...);
+        return result;
+    }
+
+    static size_t hash(const Vertex &vertex) {
+        size_t seed = 0;
+        (vertex_detail::hashCombine(seed, vertex_detail::hashValue(Attributes::get(vertex))), ...);
+        return seed;
+    }
+
+    static bool equal(const Vertex &a, const Vertex &b) {
+        return ((Attributes::get(a) == Attributes::get(b)) && ...);
+    }
+};
+
+template <typename Vertex>
+struct VertexLayoutOf;
+
+// Copies the attributes both layouts share, e.g. Node to PositionVertex.
+template <typename To, typename From>
+To convertVertex(const From &vertex) {
+    return VertexLayoutOf<To>::fill(VertexLayoutOf<From>::source(vertex));
+}
+
+template <typename Vertex>
+struct VertexHash {
+    size_t operator()(const Vertex &vertex) const { return VertexLayoutOf<Vertex>::hash(vertex); }
+};
+
+template <typename Vertex>
+struct VertexEqual {
+    bool operator()(const Vertex &a, const Vertex &b) const { return VertexLayoutOf<Vertex>::equal(a, b); }
+};
+
+#endif // VERTEX_LAYOUT
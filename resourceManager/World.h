@@ -1,11 +1,90 @@
 #ifndef WORLD
 #define WORLD
-#include <set>
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "Entity.h"
 #include "../resourceManager/Component.h"
 
-using EntityMap = std::unordered_map<Entity, EntityStructure>;
+// Dense storage for one component type (a sparse set): components sit
+// contiguously in insertion order, m_sparse maps an entity to its slot.
+// Deleting moves the last component into the freed slot.
+template <typename T>
+class ComponentStorage {
+public:
+	static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+	bool has(Entity id) const {
+		return id < m_sparse.size() && m_sparse[id] != kNone;
+	}
+
+	T *get(Entity id) {
+		return has(id) ? &m_components[m_sparse[id]] : nullptr;
+	}
+
+	const T *get(Entity id) const {
+		return has(id) ? &m_components[m_sparse[id]] : nullptr;
+	}
+
+	template <typename... Args>
+	T &emplace(Entity id, Args &&...args) {
+		if (has(id)) {
+			T &component = m_components[m_sparse[id]];
+			component = T(std::forward<Args>(args)...);
+			return component;
+		}
+		if (id >= m_sparse.size()) {
+			m_sparse.resize(static_cast<size_t>(id) + 1, kNone);
+		}
+		m_sparse[id] = static_cast<uint32_t>(m_components.size());
+		m_entities.push_back(id);
+		return m_components.emplace_back(std::forward<Args>(args)...);
+	}
+
+	bool remove(Entity id) {
+		if (!has(id)) {
+			return false;
+		}
+		const uint32_t slot = m_sparse[id];
+		const Entity last = m_entities.back();
+		if (slot + 1 != m_components.size()) {
+			m_components[slot] = std::move(m_components.back());
+			m_entities[slot] = last;
+			m_sparse[last] = slot;
+		}
+		m_components.pop_back();
+		m_entities.pop_back();
+		m_sparse[id] = kNone;
+		return true;
+	}
+
+	void reserve(size_t count, Entity maxEntity) {
+		m_components.reserve(count);
+		m_entities.reserve(count);
+		if (maxEntity >= m_sparse.size()) {
+			m_sparse.resize(static_cast<size_t>(maxEntity) + 1, kNone);
+		}
+	}
+
+	void clear() {
+		m_components.clear();
+		m_entities.clear();
+		m_sparse.clear();
+	}
+
+	size_t size() const { return m_components.size(); }
+	// Parallel arrays: components()[i] belongs to entities()[i].
+	std::vector<T> &components() { return m_components; }
+	const std::vector<T> &components() const { return m_components; }
+	const std::vector<Entity> &entities() const { return m_entities; }
+
+private:
+	std::vector<uint32_t> m_sparse;
+	std::vector<Entity> m_entities;
+	std::vector<T> m_components;
+};
 
 class World {
 public:
@@ -17,69 +96,77 @@ public:
 
 	Entity createEntity() {
 		const Entity id = generateEntityId();
-		entities.insert(id);
+		entities.push_back(id);
 		return id;
 	}
 
 	template <typename T>
-	bool entityHasComponent(Entity id) {
-		if (!components.count(id)) return false;
-		const auto& entity = components.at(id);
-		if constexpr (std::is_same_v<T, RenderElement>) {
-			return entity.hasRenderElement();
-		}
-		else if constexpr (std::is_same_v<T, TransformElement>) {
-			return entity.hasTransformElement();
-		}
-		return false;
+	bool entityHasComponent(Entity id) const {
+		return storage<T>().has(id);
 	}
 
 	template <typename T>
 	bool deleteComponent(Entity id) {
-		if (!components.count(id)) return false;
-		auto& entity = components[id];
-		if constexpr (std::is_same_v<T, RenderElement>) {
-			entity.add(std::shared_ptr<RenderElement>{});
-			return true;
-		}
-		else if constexpr (std::is_same_v<T, TransformElement>) {
-			entity.add(std::shared_ptr<TransformElement>{});
-			return true;
-		}
-		return false;
+		return storage<T>().remove(id);
 	}
 
 	template <typename T>
 	void addComponent(Entity id, T&& component) {
-		if (!components.count(id)) {
-			components.emplace(id, EntityStructure());
-		}
-		auto& entity = components[id];
-		entity.add(std::make_shared<T>(component));
+		storage<std::decay_t<T>>().emplace(id, std::forward<T>(component));
 	}
 
 	template <typename T>
 	void addComponent(T&& component) {
-		auto id = createEntity();
-		if (!components.count(id)) {
-			components.emplace(id, EntityStructure());
-		}
-		auto& entity = components[id];
-		entity.add(std::make_shared<T>(component));
+		addComponent(createEntity(), std::forward<T>(component));
 	}
 
-	auto& getComponent(Entity id) {
-		return components.at(id);
+	EntityStructure getComponent(Entity id) {
+		return {renders.get(id), transforms.get(id)};
 	}
 
-	std::set<Entity>& getAllEntities() {
+	// Ids in creation order.
+	const std::vector<Entity>& getAllEntities() const {
 		return entities;
 	}
 
+	template <typename T>
+	ComponentStorage<T>& storage() {
+		if constexpr (std::is_same_v<T, RenderElement>) {
+			return renders;
+		}
+		else {
+			static_assert(std::is_same_v<T, TransformElement>, "unknown component type");
+			return transforms;
+		}
+	}
+
+	template <typename T>
+	const ComponentStorage<T>& storage() const {
+		return const_cast<World *>(this)->storage<T>();
+	}
+
+	Entity nextId() const {
+		return nextEntityId;
+	}
+
+	void clear() {
+		nextEntityId = 0;
+		entities.clear();
+		renders.clear();
+		transforms.clear();
+	}
+
+	// Used by snapshot loading, which fills the component storage directly.
+	void restoreEntities(std::vector<Entity> &&ids, Entity nextId) {
+		entities = std::move(ids);
+		nextEntityId = nextId;
+	}
+
 private:
 	Entity nextEntityId = 0;
-	std::set<Entity> entities;
-	EntityMap components;
+	std::vector<Entity> entities;
+	ComponentStorage<RenderElement> renders;
+	ComponentStorage<TransformElement> transforms;
 };
 
-#endif // WORLD
\ No newline at end of file
+#endif // WORLD
@@ -0,0 +1,351 @@
+#include "WorldSnapshot.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'G', 'E', 'W'};
+constexpr uint32_t kNoMesh = 0xFFFFFFFF;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entityCount;
+    uint32_t nextEntityId;
+    uint32_t transformCount;
+    uint32_t renderCount;
+    uint32_t meshCount;
+    uint32_t reserved;
+    uint64_t entitiesOffset;
+    uint64_t transformsOffset;
+    uint64_t rendersOffset;
+    uint64_t meshesOffset;
+    uint64_t fileSize;
+};
+
+// TransformElement has a vtable; only its data goes to disk.
+struct TransformRecord {
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+};
+
+enum class MeshKind : uint32_t {
+    File = 0,
+    StreamedFile = 1,
+    Inline = 2,
+};
+
+struct MeshRecord {
+    MeshKind kind;
+    uint32_t pathLength;
+    uint32_t nodeCount;
+    uint32_t indexCount;
+};
+
+// Sections are copied to and from memory as they are, never byte-swapped.
+static_assert(std::endian::native == std::endian::little, "snapshots are little-endian");
+static_assert(sizeof(SnapshotHeader) == 72);
+static_assert(sizeof(TransformRecord) == 36);
+static_assert(sizeof(Node) == 32 && VertexLayoutOf<Node>::packed, "Node is stored as raw bytes");
+
+constexpr uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string &path) : m_file(path, std::ios::binary | std::ios::trunc) {
+        if (!m_file.is_open()) {
+            throw std::runtime_error("saveWorldSnapshot: failed to open " + path);
+        }
+    }
+
+    uint64_t offset() const { return m_offset; }
+
+    void write(const void *data, size_t size) {
+        m_file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        m_offset += size;
+    }
+
+    template <typename T>
+    void writeArray(const std::vector<T> &values) {
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    void pad() {
+        static const char zeros[8] = {};
+        write(zeros, align8(m_offset) - m_offset);
+    }
+
+    void finish(const SnapshotHeader &header, const std::string &path) {
+        m_file.seekp(0);
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_file.flush();
+        if (!m_file) {
+            throw std::runtime_error("saveWorldSnapshot: failed to write " + path);
+        }
+    }
+
+private:
+    std::ofstream m_file;
+    uint64_t m_offset = 0;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const MappedFile &file, const std::string &path) : m_file(file), m_path(path) {}
+
+    template <typename T>
+    const char *array(uint64_t offset, uint64_t count) const {
+        if (offset > m_file.size() || count > (m_file.size() - offset) / sizeof(T)) {
+            fail("section out of bounds");
+        }
+        // The mapping is page-aligned; sections are read in place as arrays.
+        if (offset % 8 != 0) {
+            fail("section not 8-byte aligned");
+        }
+        return m_file.data() + offset;
+    }
+
+    [[noreturn]] void fail(const std::string &reason) const {
+        throw std::runtime_error("loadWorldSnapshot: " + m_path + ": " + reason);
+    }
+
+private:
+    const MappedFile &m_file;
+    const std::string &m_path;
+};
+
+}
+
+void saveWorldSnapshot(const World &world, const std::string &path) {
+    PROFILE_FUNCTION();
+    const auto &transforms = world.storage<TransformElement>();
+    const auto &renders = world.storage<RenderElement>();
+
+    // Mesh table in order of first use.
+    std::vector<const Mesh *> meshes;
+    std::unordered_map<const Mesh *, uint32_t> meshIndices;
+    std::vector<uint32_t> renderMeshes;
+    renderMeshes.reserve(renders.size());
+    for (const auto &render : renders.components()) {
+        if (!render.mesh) {
+            renderMeshes.push_back(kNoMesh);
+            continue;
+        }
+        auto [it, inserted] = meshIndices.try_emplace(render.mesh.get(), static_cast<uint32_t>(meshes.size()));
+        if (inserted) {
+            meshes.push_back(render.mesh.get());
+        }
+        renderMeshes.push_back(it->second);
+    }
+
+    std::vector<TransformRecord> transformRecords;
+    transformRecords.reserve(transforms.size());
+    for (const auto &transform : transforms.components()) {
+        transformRecords.push_back({transform.position, transform.rotation, transform.scale});
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kWorldSnapshotVersion;
+    header.entityCount = static_cast<uint32_t>(world.getAllEntities().size());
+    header.nextEntityId = world.nextId();
+    header.transformCount = static_cast<uint32_t>(transforms.size());
+    header.renderCount = static_cast<uint32_t>(renders.size());
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+
+    SnapshotWriter writer(path);
+    writer.write(&header, sizeof(header));
+    writer.pad();
+
+    header.entitiesOffset = writer.offset();
+    writer.writeArray(world.getAllEntities());
+    writer.pad();
+
+    header.transformsOffset = writer.offset();
+    writer.writeArray(transforms.entities());
+    writer.pad();
+    writer.writeArray(transformRecords);
+    writer.pad();
+
+    header.rendersOffset = writer.offset();
+    writer.writeArray(renders.entities());
+    writer.pad();
+    writer.writeArray(renderMeshes);
+    writer.pad();
+
+    header.meshesOffset = writer.offset();
+    for (const Mesh *mesh : meshes) {
+        MeshRecord record{};
+        if (!mesh->source.empty()) {
+            record.kind = mesh->streamed ? MeshKind::StreamedFile : MeshKind::File;
+            record.pathLength = static_cast<uint32_t>(mesh->source.size());
+        }
+        else {
+            if (mesh->nodes.empty() && mesh->indexCount > 0) {
+                throw std::runtime_error("saveWorldSnapshot: generated mesh has no CPU copy to store");
+            }
+            record.kind = MeshKind::Inline;
+            record.nodeCount = static_cast<uint32_t>(mesh->nodes.size());
+            record.indexCount = static_cast<uint32_t>(mesh->indices.size());
+        }
+        writer.write(&record, sizeof(record));
+        writer.write(mesh->source.data(), record.pathLength);
+        writer.pad();
+        if (record.kind == MeshKind::Inline) {
+            writer.writeArray(mesh->nodes);
+            writer.writeArray(mesh->indices);
+            writer.pad();
+        }
+    }
+
+    header.fileSize = writer.offset();
+    writer.finish(header, path);
+}
+
+void loadWorldSnapshot(const std::string &path, World &world, ResourceManager &resourceManager) {
+    PROFILE_FUNCTION();
+    world.clear();
+
+    MappedFile file(path);
+    SnapshotReader reader(file, path);
+    if (!file.isOpen()) {
+        reader.fail("cannot open");
+    }
+    if (file.size() < sizeof(SnapshotHeader)) {
+        reader.fail("truncated header");
+    }
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        reader.fail("not a world snapshot");
+    }
+    if (header.version != kWorldSnapshotVersion) {
+        reader.fail("version " + std::to_string(header.version) + ", expected " +
+                    std::to_string(kWorldSnapshotVersion));
+    }
+    if (header.fileSize != file.size()) {
+        reader.fail("size mismatch");
+    }
+
+    auto checkEntity = [&](Entity id) {
+        if (id >= header.nextEntityId) {
+            reader.fail("entity id out of range");
+        }
+    };
+
+    // Every section is bounds- and range-checked before `world` is touched,
+    // so a bad file cannot leave half of it loaded.
+    std::vector<Entity> entities(header.entityCount);
+    std::memcpy(entities.data(), reader.array<Entity>(header.entitiesOffset, header.entityCount),
+                entities.size() * sizeof(Entity));
+    for (Entity id : entities) {
+        checkEntity(id);
+    }
+
+    const auto *transformIds = reinterpret_cast<const Entity *>(
+        reader.array<Entity>(header.transformsOffset, header.transformCount));
+    const char *transformRecords = reader.array<TransformRecord>(
+        align8(header.transformsOffset + uint64_t(header.transformCount) * sizeof(Entity)),
+        header.transformCount);
+    for (uint32_t i = 0; i < header.transformCount; i++) {
+        checkEntity(transformIds[i]);
+    }
+
+    const auto *renderIds = reinterpret_cast<const Entity *>(
+        reader.array<Entity>(header.rendersOffset, header.renderCount));
+    const auto *meshIndices = reinterpret_cast<const uint32_t *>(reader.array<uint32_t>(
+        align8(header.rendersOffset + uint64_t(header.renderCount) * sizeof(Entity)),
+        header.renderCount));
+    for (uint32_t i = 0; i < header.renderCount; i++) {
+        checkEntity(renderIds[i]);
+        if (meshIndices[i] != kNoMesh && meshIndices[i] >= header.meshCount) {
+            reader.fail("mesh index out of range");
+        }
+    }
+
+    // Meshes go through the ResourceManager, not `world`; a failure here
+    // still leaves `world` empty.
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    meshes.reserve(header.meshCount);
+    {
+        PROFILE_SCOPE("meshes");
+        uint64_t offset = header.meshesOffset;
+        for (uint32_t i = 0; i < header.meshCount; i++) {
+            MeshRecord record;
+            std::memcpy(&record, reader.array<MeshRecord>(offset, 1), sizeof(record));
+            offset += sizeof(record);
+            const std::string source(reader.array<char>(offset, record.pathLength), record.pathLength);
+            offset = align8(offset + record.pathLength);
+
+            std::shared_ptr<Mesh> mesh;
+            if (record.kind == MeshKind::File) {
+                mesh = resourceManager.getMesh(source);
+            }
+            else if (record.kind == MeshKind::StreamedFile) {
+                mesh = resourceManager.streamMesh(source);
+            }
+            else if (record.kind == MeshKind::Inline) {
+                mesh = std::make_shared<Mesh>();
+                const char *nodes = reader.array<Node>(offset, record.nodeCount);
+                mesh->nodes.assign(reinterpret_cast<const Node *>(nodes),
+                                   reinterpret_cast<const Node *>(nodes) + record.nodeCount);
+                offset += uint64_t(record.nodeCount) * sizeof(Node);
+                const char *indices = reader.array<uint32_t>(offset, record.indexCount);
+                mesh->indices.resize(record.indexCount);
+                std::memcpy(mesh->indices.data(), indices, mesh->indices.size() * sizeof(uint32_t));
+                mesh->indexCount = record.indexCount;
+                offset = align8(offset + uint64_t(record.indexCount) * sizeof(uint32_t));
+            }
+            else {
+                reader.fail("unknown mesh kind");
+            }
+            if (!mesh) {
+                reader.fail("failed to load mesh " + source);
+            }
+            meshes.push_back(std::move(mesh));
+        }
+    }
+
+    const uint64_t maxEntity = header.nextEntityId ? header.nextEntityId - 1 : 0;
+    try {
+        {
+            PROFILE_SCOPE("transforms");
+            auto &transforms = world.storage<TransformElement>();
+            transforms.reserve(header.transformCount, static_cast<Entity>(maxEntity));
+            TransformElement transform;
+            for (uint32_t i = 0; i < header.transformCount; i++) {
+                TransformRecord record;
+                std::memcpy(&record, transformRecords + uint64_t(i) * sizeof(TransformRecord), sizeof(record));
+                transform.position = record.position;
+                transform.rotation = record.rotation;
+                transform.scale = record.scale;
+                transforms.emplace(transformIds[i], transform);
+            }
+        }
+
+        {
+            PROFILE_SCOPE("renders");
+            auto &renders = world.storage<RenderElement>();
+            renders.reserve(header.renderCount, static_cast<Entity>(maxEntity));
+            for (uint32_t i = 0; i < header.renderCount; i++) {
+                const uint32_t mesh = meshIndices[i];
+                renders.emplace(renderIds[i], mesh == kNoMesh ? nullptr : meshes[mesh]);
+            }
+        }
+
+        world.restoreEntities(std::move(entities), header.nextEntityId);
+    }
+    catch (...) {
+        // Only allocation can fail past validation; do not keep a partial world.
+        world.clear();
+        throw;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef WORLD_SNAPSHOT
+#define WORLD_SNAPSHOT
+
+#include "ResourceManager.h"
+#include "World.h"
+#include <string>
+
+// Binary World snapshot. Little-endian, so it only builds on little-endian
+// hosts; every section 8-byte aligned, which loading checks:
+//
+//   SnapshotHeader
+//   entities     Entity[entityCount]
+//   transforms   Entity[transformCount], TransformRecord[transformCount]
+//   renders      Entity[renderCount], uint32_t mesh index[renderCount]
+//   meshes       meshCount x (MeshRecord, path bytes, Node[], uint32_t[])
+//
+// Meshes loaded from files are stored as their path and resolved through the
+// ResourceManager on load; meshes without a source (generated ones) are
+// stored inline. Bump kWorldSnapshotVersion on any layout change.
+constexpr uint32_t kWorldSnapshotVersion = 1;
+
+// Throws std::runtime_error if the file cannot be written or a mesh without a
+// source has no CPU copy to embed.
+void saveWorldSnapshot(const World &world, const std::string &path);
+
+// Replaces the contents of `world`. The file is memory-mapped and copied
+// straight into the component arrays, which are sized once up front; only
+// meshes are allocated individually. Throws std::runtime_error on a missing,
+// truncated or incompatible file, leaving `world` empty.
+void loadWorldSnapshot(const std::string &path, World &world, ResourceManager &resourceManager);
+
+#endif // WORLD_SNAPSHOT
@@ -0,0 +1,22 @@
+#version 450
+
+// Set by RenderCore to the size of its texture array, which the device
+// limits may cap below 1024.
+layout(constant_id = 0) const uint kTextureCount = 1024;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[kTextureCount];
+
+// The vertex stage owns bytes 0-63 (the model matrix).
+layout(push_constant) uniform TextureSlot {
+    layout(offset = 64) uint slot;
+} pushed;
+
+layout(location = 0) in vec3 color;
+layout(location = 1) in vec2 textureCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Slot 0 is a white texel, so untextured meshes keep their vertex color.
+    outColor = vec4(color, 1.0) * texture(textures[pushed.slot], textureCoord);
+}
@@ -0,0 +1,36 @@
+#ifndef TEST_CHECK
+#define TEST_CHECK
+
+#include <iostream>
+
+// Minimal assertions for the ctest executables: a failed CHECK prints the
+// expression and makes the test return non-zero, but keeps running.
+inline int &testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(expression)                                                                       \
+    do {                                                                                        \
+        if (!(expression)) {                                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #expression "\n";    \
+            testFailures()++;                                                                   \
+        }                                                                                       \
+    } while (false)
+
+#define CHECK_THROWS(statement)                                                                 \
+    do {                                                                                        \
+        bool thrown = false;                                                                    \
+        try {                                                                                   \
+            statement;                                                                          \
+        }                                                                                       \
+        catch (...) {                                                                           \
+            thrown = true;                                                                      \
+        }                                                                                       \
+        if (!thrown) {                                                                          \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": no exception from " #statement "\n"; \
+            testFailures()++;                                                                   \
+        }                                                                                       \
+    } while (false)
+
+#endif // TEST_CHECK
@@ -0,0 +1,196 @@
+#include "Check.h"
+#include "../resourceManager/ResourceManager.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+// The loader only keeps faces with texture coordinates.
+const char *kTriangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nf 1/1 2/2 3/3\n";
+
+// Exercises every rule the loaders have to agree on.
+const char *kMixedObj =
+    "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 2 0 0\nv 2 1 0\n"
+    "vt 0 0\nvt 1 0\nvt 1 1\n"
+    // A texcoord with only u.
+    "vt 0.5\n"
+    "vn 0 0 1\n"
+    // A quad, fan triangulated.
+    "f 1/1 2/2 3/3 4/4\n"
+    // Without texcoords: dropped.
+    "f 1 2 3\nf 2//1 5//1 6//1\n"
+    // Normals are skipped.
+    "f 2/2/1 5/1/1 6/3/1\n"
+    // Negative indices count back from the last v/vt so far.
+    "f -4/-4 -2/-3 -1/-1\n"
+    // A pentagon.
+    "f 1/1 2/2 5/3 6/4 3/1\n";
+
+void writeFile(const std::filesystem::path &path, const std::string &text) {
+    std::ofstream(path, std::ios::trunc) << text;
+}
+
+// Every call must land in exactly one of hits and misses.
+void expectCounters(const CacheStats &stats, uint64_t hits, uint64_t misses, uint64_t pathAliasHits,
+                    uint64_t fileHashHits, uint64_t geometryHashHits) {
+    CHECK(stats.hits == hits);
+    CHECK(stats.misses == misses);
+    CHECK(stats.pathAliasHits == pathAliasHits);
+    CHECK(stats.fileHashHits == fileHashHits);
+    CHECK(stats.geometryHashHits == geometryHashHits);
+}
+
+// Polls like the renderer does, once per "frame", until the stream is done.
+bool finishStream(ResourceManager &resourceManager, const Mesh &mesh) {
+    for (int frame = 0; frame < 1000; frame++) {
+        resourceManager.pollStreams(4);
+        if (!resourceManager.isStreaming(mesh)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// The triangle list a mesh draws, one node per index.
+std::vector<Node> triangleCorners(const Mesh &mesh) {
+    std::vector<Node> corners;
+    for (uint32_t index : mesh.indices) {
+        corners.push_back(mesh.nodes[index]);
+    }
+    return corners;
+}
+
+void testCounters(const std::filesystem::path &directory) {
+    writeFile(directory / "triangle.obj", kTriangle);
+    // Same bytes under another name.
+    writeFile(directory / "copy.obj", kTriangle);
+    // Other bytes, same geometry once parsed.
+    writeFile(directory / "commented.obj", std::string("# exported again\n") + kTriangle);
+    writeFile(directory / "other.obj", "v 0 0 0\nv 2 0 0\nv 0 2 0\nvt 0 0\nvt 1 0\nvt 0 1\nf 1/1 2/2 3/3\n");
+
+    ResourceManager resourceManager;
+    const CacheStats &stats = resourceManager.stats();
+
+    const auto mesh = resourceManager.getMesh((directory / "triangle.obj").string());
+    CHECK(mesh != nullptr);
+    expectCounters(stats, 0, 1, 0, 0, 0);
+
+    CHECK(resourceManager.getMesh((directory / "triangle.obj").string()) == mesh);
+    expectCounters(stats, 1, 1, 0, 0, 0);
+
+    CHECK(resourceManager.getMesh((directory / "." / "triangle.obj").string()) == mesh);
+    expectCounters(stats, 2, 1, 1, 0, 0);
+
+    CHECK(resourceManager.getMesh((directory / "copy.obj").string()) == mesh);
+    expectCounters(stats, 3, 1, 1, 1, 0);
+
+    CHECK(resourceManager.getMesh((directory / "commented.obj").string()) == mesh);
+    expectCounters(stats, 4, 1, 1, 1, 1);
+
+    const auto other = resourceManager.getMesh((directory / "other.obj").string());
+    CHECK(other != nullptr && other != mesh);
+    expectCounters(stats, 4, 2, 1, 1, 1);
+
+    CHECK(resourceManager.getMesh((directory / "missing.obj").string()) == nullptr);
+    expectCounters(stats, 4, 3, 1, 1, 1);
+}
+
+// Streamed sections, concatenated, draw exactly what getMesh() loads.
+void testStreamMatchesGetMesh(const std::filesystem::path &directory) {
+    const std::string path = (directory / "mixed.obj").string();
+    writeFile(path, kMixedObj);
+
+    ResourceManager loaded;
+    const auto mesh = loaded.getMesh(path);
+    CHECK(mesh != nullptr && !mesh->indices.empty());
+
+    ResourceManager streamed;
+    StreamOptions options;
+    // Forces several sections out of a small file.
+    options.sectionVertices = 4;
+    const auto stream = streamed.streamMesh(path, options);
+    CHECK(stream != nullptr);
+    CHECK(finishStream(streamed, *stream));
+    CHECK(stream->sections.size() > 1);
+
+    std::vector<Node> streamedCorners;
+    for (const Mesh &section : stream->sections) {
+        const std::vector<Node> corners = triangleCorners(section);
+        streamedCorners.insert(streamedCorners.end(), corners.begin(), corners.end());
+    }
+    if (mesh) {
+        CHECK(streamedCorners == triangleCorners(*mesh));
+    }
+}
+
+// A stream that ended without sections is not started again every frame.
+void testFinishedStreamNotRestarted(const std::filesystem::path &directory) {
+    const std::string path = (directory / "faceless.obj").string();
+    writeFile(path, "v 0 0 0\nv 1 0 0\nv 0 1 0\n");
+
+    ResourceManager resourceManager;
+    const auto mesh = resourceManager.streamMesh(path);
+    CHECK(mesh != nullptr);
+    CHECK(finishStream(resourceManager, *mesh));
+    CHECK(mesh->sections.empty());
+
+    for (int frame = 0; frame < 10; frame++) {
+        CHECK(resourceManager.restoreCpuCopy(*mesh));
+        CHECK(!resourceManager.isStreaming(*mesh));
+        resourceManager.pollStreams(4);
+    }
+}
+
+// restoreCpuCopy() reads the file again only for a mesh whose copy was dropped.
+void testRestoreCpuCopy(const std::filesystem::path &directory) {
+    const std::string emptyPath = (directory / "empty.obj").string();
+    const std::string trianglePath = (directory / "restore.obj").string();
+    writeFile(emptyPath, "v 0 0 0\nv 1 0 0\nv 0 1 0\n");
+    writeFile(trianglePath, kTriangle);
+
+    ResourceManager resourceManager(CacheBudget{.dropCpuAfterUpload = true});
+
+    // Nothing to upload, so nothing was dropped: the changed file is not read.
+    const auto empty = resourceManager.getMesh(emptyPath);
+    CHECK(empty != nullptr);
+    CHECK(empty->nodes.empty());
+    writeFile(emptyPath, kTriangle);
+    CHECK(resourceManager.restoreCpuCopy(*empty));
+    CHECK(empty->nodes.empty());
+    CHECK(empty->indices.empty());
+
+    const auto mesh = resourceManager.getMesh(trianglePath);
+    CHECK(mesh != nullptr);
+    const size_t nodeCount = mesh->nodes.size();
+    const size_t cpuBytes = resourceManager.stats().cpuBytesResident;
+    CHECK(nodeCount == 3);
+    resourceManager.onMeshUploaded(*mesh, 100);
+    CHECK(mesh->nodes.empty());
+    CHECK(mesh->indices.empty());
+    CHECK(resourceManager.stats().cpuCopiesDropped == 1);
+    CHECK(resourceManager.stats().cpuBytesResident < cpuBytes);
+
+    CHECK(resourceManager.restoreCpuCopy(*mesh));
+    CHECK(mesh->nodes.size() == nodeCount);
+    CHECK(mesh->indices.size() == nodeCount);
+    CHECK(mesh->indexCount == nodeCount);
+    CHECK(resourceManager.stats().cpuBytesResident == cpuBytes);
+}
+
+}
+
+int main() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "sge_resource_manager_test";
+    std::filesystem::create_directories(directory);
+
+    testCounters(directory);
+    testStreamMatchesGetMesh(directory);
+    testFinishedStreamNotRestarted(directory);
+    testRestoreCpuCopy(directory);
+
+    std::filesystem::remove_all(directory);
+    return testFailures() ? 1 : 0;
+}
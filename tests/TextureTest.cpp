@@ -0,0 +1,133 @@
+#include "Check.h"
+#include "../resourceManager/Texture.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Image {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> rgba;
+
+    uint8_t *pixel(uint32_t x, uint32_t y) { return rgba.data() + (size_t(y) * width + x) * 4; }
+};
+
+Image makeImage(uint32_t width, uint32_t height) {
+    return {width, height, std::vector<uint8_t>(size_t(width) * height * 4)};
+}
+
+TextureData roundTrip(const Image &image, bool generateMips) {
+    const TextureData rgba = buildTextureMips(image.rgba.data(), image.width, image.height, generateMips);
+    const TextureData bc1 = compressBC1(rgba);
+    CHECK(bc1.format == TextureFormat::BC1);
+    const TextureData decoded = decompressBC1(bc1);
+    CHECK(decoded.format == TextureFormat::RGBA8);
+    CHECK(decoded.mips.size() == rgba.mips.size());
+    CHECK(decoded.bytes.size() == rgba.bytes.size());
+    for (size_t level = 0; level < decoded.mips.size() && level < rgba.mips.size(); level++) {
+        CHECK(decoded.mips[level].width == rgba.mips[level].width);
+        CHECK(decoded.mips[level].height == rgba.mips[level].height);
+        CHECK(decoded.mips[level].offset == rgba.mips[level].offset);
+        CHECK(decoded.mips[level].size == rgba.mips[level].size);
+    }
+    return decoded;
+}
+
+// Largest per-channel difference over the opaque pixels of the top level.
+int maxColorError(const Image &image, const TextureData &decoded) {
+    int error = 0;
+    for (size_t i = 0; i < image.rgba.size(); i += 4) {
+        if (image.rgba[i + 3] < 128) {
+            continue;
+        }
+        for (int c = 0; c < 3; c++) {
+            error = std::max(error, std::abs(image.rgba[i + c] - decoded.bytes[i + c]));
+        }
+    }
+    return error;
+}
+
+}
+
+int main() {
+    // Opaque blocks of one RGB565-exact color each come back unchanged.
+    {
+        const uint8_t colors[4][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255}};
+        Image image = makeImage(8, 8);
+        for (uint32_t y = 0; y < 8; y++) {
+            for (uint32_t x = 0; x < 8; x++) {
+                const uint8_t *color = colors[(y / 4) * 2 + x / 4];
+                uint8_t *pixel = image.pixel(x, y);
+                pixel[0] = color[0], pixel[1] = color[1], pixel[2] = color[2], pixel[3] = 255;
+            }
+        }
+        const TextureData decoded = roundTrip(image, false);
+        CHECK(decoded.bytes == image.rgba);
+    }
+
+    // A gradient along the blocks' bounding-box diagonal, the line range fit
+    // encodes, stays within RGB565 precision plus half a palette step.
+    {
+        Image image = makeImage(16, 16);
+        for (uint32_t y = 0; y < 16; y++) {
+            for (uint32_t x = 0; x < 16; x++) {
+                uint8_t *pixel = image.pixel(x, y);
+                pixel[0] = uint8_t(x * 16), pixel[1] = uint8_t(x * 8), pixel[2] = 128, pixel[3] = 255;
+            }
+        }
+        const TextureData decoded = roundTrip(image, false);
+        CHECK(maxColorError(image, decoded) <= 12);
+        for (size_t i = 3; i < decoded.bytes.size(); i += 4) {
+            CHECK(decoded.bytes[i] == 255);
+        }
+    }
+
+    // 1-bit alpha: transparent pixels decode to transparent black, the rest
+    // stay opaque.
+    {
+        Image image = makeImage(8, 4);
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 8; x++) {
+                uint8_t *pixel = image.pixel(x, y);
+                pixel[0] = 0, pixel[1] = 255, pixel[2] = 0;
+                pixel[3] = (x + y) % 2 ? 40 : 220;
+            }
+        }
+        const TextureData decoded = roundTrip(image, false);
+        for (size_t i = 0; i < image.rgba.size(); i += 4) {
+            if (image.rgba[i + 3] < 128) {
+                CHECK(decoded.bytes[i] == 0 && decoded.bytes[i + 1] == 0 && decoded.bytes[i + 2] == 0);
+                CHECK(decoded.bytes[i + 3] == 0);
+            }
+            else {
+                CHECK(decoded.bytes[i + 1] == 255 && decoded.bytes[i + 3] == 255);
+            }
+        }
+    }
+
+    // Sizes that are not a multiple of 4, down to 1x1: partial edge blocks
+    // keep their pixels and nothing is written past a level.
+    {
+        Image image = makeImage(7, 5);
+        for (uint32_t y = 0; y < 5; y++) {
+            for (uint32_t x = 0; x < 7; x++) {
+                uint8_t *pixel = image.pixel(x, y);
+                const bool edge = x >= 4 || y >= 4;
+                pixel[0] = edge ? 0 : 255, pixel[1] = 0, pixel[2] = edge ? 255 : 0, pixel[3] = 255;
+            }
+        }
+        const TextureData decoded = roundTrip(image, true);
+        CHECK(decoded.mips.size() == 3);
+        CHECK(decoded.bytes.size() == (7 * 5 + 3 * 2 + 1 * 1) * 4);
+        for (size_t i = 0; i < image.rgba.size(); i++) {
+            CHECK(decoded.bytes[i] == image.rgba[i]);
+        }
+        for (size_t i = 3; i < decoded.bytes.size(); i += 4) {
+            CHECK(decoded.bytes[i] == 255);
+        }
+    }
+
+    return testFailures() ? 1 : 0;
+}
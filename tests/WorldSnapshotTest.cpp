@@ -0,0 +1,115 @@
+#include "Check.h"
+#include "../resourceManager/Scene.h"
+#include "../resourceManager/WorldSnapshot.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// Byte offsets into SnapshotHeader (see WorldSnapshot.cpp).
+constexpr size_t kRenderCountOffset = 20;
+constexpr size_t kTransformsOffsetOffset = 40;
+constexpr size_t kRendersOffsetOffset = 48;
+
+std::vector<char> readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::string &path, const std::vector<char> &bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+template <typename T>
+T field(const std::vector<char> &bytes, size_t offset) {
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void setField(std::vector<char> &bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+void buildWorld(World &world) {
+    auto grid = generateGridMesh(2, {1.0f, 0.0f, 0.0f});
+    for (int i = 0; i < 8; i++) {
+        const Entity entity = world.createEntity();
+        TransformElement transform;
+        transform.position = {float(i), 0.0f, 0.0f};
+        world.addComponent(entity, std::move(transform));
+        world.addComponent(entity, RenderElement(grid));
+    }
+}
+
+// Loads a corrupted snapshot into a world that already holds entities.
+void expectRejected(const std::string &path, ResourceManager &resourceManager) {
+    World world;
+    buildWorld(world);
+    CHECK_THROWS(loadWorldSnapshot(path, world, resourceManager));
+    CHECK(world.getAllEntities().empty());
+    CHECK(world.storage<TransformElement>().size() == 0);
+    CHECK(world.storage<RenderElement>().size() == 0);
+}
+
+}
+
+int main() {
+    const std::string path = (std::filesystem::temp_directory_path() / "sge_world_snapshot_test.bin").string();
+    ResourceManager resourceManager;
+
+    World original;
+    buildWorld(original);
+    saveWorldSnapshot(original, path);
+    const std::vector<char> valid = readFile(path);
+
+    {
+        World loaded;
+        loadWorldSnapshot(path, loaded, resourceManager);
+        CHECK(loaded.getAllEntities() == original.getAllEntities());
+        CHECK(loaded.storage<TransformElement>().size() == 8);
+        CHECK(loaded.storage<RenderElement>().size() == 8);
+    }
+
+    // Renders section runs past the end of the file; transforms before it are fine.
+    {
+        std::vector<char> bytes = valid;
+        setField<uint32_t>(bytes, kRenderCountOffset, 1u << 20);
+        writeFile(path, bytes);
+        expectRejected(path, resourceManager);
+    }
+
+    // A render refers to a mesh the file does not have.
+    {
+        std::vector<char> bytes = valid;
+        const auto rendersOffset = field<uint64_t>(bytes, kRendersOffsetOffset);
+        const auto renderCount = field<uint32_t>(bytes, kRenderCountOffset);
+        const uint64_t meshIndices = (rendersOffset + renderCount * sizeof(Entity) + 7) & ~uint64_t(7);
+        setField<uint32_t>(bytes, meshIndices + 3 * sizeof(uint32_t), 42u);
+        writeFile(path, bytes);
+        expectRejected(path, resourceManager);
+    }
+
+    // Transform ids moved half a slot: in bounds and valid ids, but misaligned.
+    {
+        std::vector<char> bytes = valid;
+        setField<uint64_t>(bytes, kTransformsOffsetOffset, field<uint64_t>(bytes, kTransformsOffsetOffset) + 4);
+        writeFile(path, bytes);
+        expectRejected(path, resourceManager);
+    }
+
+    // Cut off at the end: the size recorded in the header no longer matches.
+    {
+        std::vector<char> bytes = valid;
+        bytes.resize(bytes.size() - 16);
+        writeFile(path, bytes);
+        expectRejected(path, resourceManager);
+    }
+
+    std::filesystem::remove(path);
+    return testFailures() ? 1 : 0;
+}
@@ -3,12 +3,24 @@
 #include "MainWindow.h"
 #include <QVBoxLayout>
 #include "QVulkanMainWindow.h"
+#include "StatsPanel.h"
+#include <QHBoxLayout>
 #include <QPushButton>
-MainWindow::MainWindow(QVulkanWindow* window, QWidget* parent) : QWidget(parent)
+#include <QShortcut>
+MainWindow::MainWindow(QVulkanWindow* window, bool showStats, QWidget* parent) : QWidget(parent)
 {
     QWidget *wrapper = QWidget::createWindowContainer(window);
-    QVBoxLayout *layout = new QVBoxLayout;
-    layout->addWidget(wrapper);
+    QHBoxLayout *layout = new QHBoxLayout;
+    layout->addWidget(wrapper, 1);
+
+    m_statsPanel = new StatsPanel(this);
+    m_statsPanel->setVisible(showStats);
+    layout->addWidget(m_statsPanel);
+    // The Vulkan window takes keyboard focus, so the shortcut is application-wide.
+    QShortcut *toggleStats = new QShortcut(QKeySequence(Qt::Key_F3), this);
+    toggleStats->setContext(Qt::ApplicationShortcut);
+    connect(toggleStats, &QShortcut::activated, this,
+            [this]() { m_statsPanel->setVisible(!m_statsPanel->isVisible()); });
     
     setLayout(layout);
     setWindowTitle("Qt + Vulkan ECS Renderer");
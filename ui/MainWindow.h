@@ -5,9 +5,15 @@
 #include <QChildEvent>
 #include <QVulkanWindow>
 
+class StatsPanel;
+
 class MainWindow : public QWidget {
 public: 
-	explicit MainWindow(QVulkanWindow* window, QWidget* parent = nullptr);
+	// The stats panel starts hidden unless showStats; F3 toggles it.
+	explicit MainWindow(QVulkanWindow* window, bool showStats = false, QWidget* parent = nullptr);
+
+private:
+	StatsPanel *m_statsPanel = nullptr;
 };
 
-#endif // MAIN_WINDOW
\ No newline at end of file
+#endif // MAIN_WINDOW
@@ -1,8 +1,9 @@
 #include "QVulkanMainWindow.h"
 #include "../renderer/QVulkanRenderer.h"
 
-QVulkanMainWindow::QVulkanMainWindow(QWindow *parent, ResourceManager *resourceManager, World *world)
-    : QVulkanWindow(parent), m_resourceManager(resourceManager), m_world(world)
+QVulkanMainWindow::QVulkanMainWindow(QWindow *parent, ResourceManager *resourceManager, World *world,
+                                     Simulation *simulation)
+    : QVulkanWindow(parent), m_resourceManager(resourceManager), m_world(world), m_simulation(simulation)
 {
 }
 
@@ -15,5 +16,6 @@ QVulkanMainWindow::~QVulkanMainWindow()
 
 QVulkanWindowRenderer* QVulkanMainWindow::createRenderer()
 {
-	return new QVulkanRenderer(this, std::move(m_resourceManager), std::move(m_world));
+	return new QVulkanRenderer(this, std::move(m_resourceManager), std::move(m_world),
+	                           std::move(m_simulation));
 }
@@ -4,18 +4,22 @@
 #include <QVulkanWindow>
 #include <QWidget>
 #include "../resourceManager/ResourceManager.h"
+#include "../resourceManager/Simulation.h"
 #include "../resourceManager/World.h"
 
 class QVulkanMainWindow : public QVulkanWindow
 {
 public:
-	QVulkanMainWindow(QWindow *parent, ResourceManager *resourceManager, World *world);
+	// Takes ownership of all three; simulation may be null.
+	QVulkanMainWindow(QWindow *parent, ResourceManager *resourceManager, World *world,
+	                  Simulation *simulation = nullptr);
 	~QVulkanMainWindow();
 
 	QVulkanWindowRenderer* createRenderer() override;
 private:
 	std::unique_ptr<ResourceManager> m_resourceManager{};
 	std::unique_ptr<World> m_world{};
+	std::unique_ptr<Simulation> m_simulation{};
 };
 
 #endif // QVULKAN_WINDOW
@@ -0,0 +1,84 @@
+#include "StatsPanel.h"
+#include <QFontDatabase>
+#include <QLabel>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+
+constexpr int kRefreshMs = 500;
+
+bool endsWith(const std::string &text, const char *suffix)
+{
+	const size_t length = std::char_traits<char>::length(suffix);
+	return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// Units come from the name: *_us is shown in ms, *_bytes in KB/MB.
+QString formatValue(const std::string &name, double value)
+{
+	if (endsWith(name, "_us")) {
+		return QString::number(value / 1000.0, 'f', 2) + " ms";
+	}
+	if (endsWith(name, "_bytes") || endsWith(name, "_bytes_total")) {
+		if (value >= 1024.0 * 1024.0) {
+			return QString::number(value / (1024.0 * 1024.0), 'f', 1) + " MB";
+		}
+		return QString::number(value / 1024.0, 'f', 1) + " KB";
+	}
+	return QString::number(value, 'f', 0);
+}
+
+}
+
+StatsPanel::StatsPanel(QWidget *parent) : QWidget(parent)
+{
+	m_label = new QLabel(this);
+	m_label->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	m_label->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+	m_label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+	QVBoxLayout *layout = new QVBoxLayout;
+	layout->addWidget(m_label);
+	setLayout(layout);
+	setMinimumWidth(320);
+
+	QTimer *timer = new QTimer(this);
+	connect(timer, &QTimer::timeout, this, [this]() { refresh(); });
+	timer->start(kRefreshMs);
+	refresh();
+}
+
+void StatsPanel::refresh()
+{
+	if (!isVisible()) {
+		return;
+	}
+	const StatsSnapshot snapshot = Stats::snapshot();
+	QString text;
+	for (const auto &[name, histogram] : snapshot.histograms) {
+		const HistogramSnapshot window = histogram - m_previous[name];
+		m_previous[name] = histogram;
+		text += QString::fromStdString(name) + "\n";
+		if (!window.count) {
+			text += "  -\n";
+			continue;
+		}
+		text += QString("  p50 %1  p99 %2  max %3\n")
+		            .arg(formatValue(name, static_cast<double>(window.percentile(0.5))),
+		                 formatValue(name, static_cast<double>(window.percentile(0.99))),
+		                 formatValue(name, static_cast<double>(window.max)));
+		if (name == "render.frame_time_us" && window.mean() > 0.0) {
+			text += QString("  %1 fps\n").arg(1e6 / window.mean(), 0, 'f', 1);
+		}
+	}
+	for (const auto &[name, value] : snapshot.gauges) {
+		text += QString("%1  %2\n").arg(QString::fromStdString(name),
+		                                 formatValue(name, static_cast<double>(value)));
+	}
+	for (const auto &[name, value] : snapshot.counters) {
+		text += QString("%1  %2\n").arg(QString::fromStdString(name),
+		                                 formatValue(name, static_cast<double>(value)));
+	}
+	m_label->setText(text);
+}
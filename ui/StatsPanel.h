@@ -0,0 +1,24 @@
+#ifndef STATS_PANEL
+#define STATS_PANEL
+
+#include "../core/Stats.h"
+#include <QWidget>
+#include <map>
+#include <string>
+
+class QLabel;
+
+// Side panel listing every registered stat, refreshed twice a second while
+// visible. Histograms show the samples since the last refresh, not the session.
+class StatsPanel : public QWidget {
+public:
+	explicit StatsPanel(QWidget *parent = nullptr);
+
+private:
+	void refresh();
+
+	QLabel *m_label = nullptr;
+	std::map<std::string, HistogramSnapshot> m_previous;
+};
+
+#endif // STATS_PANEL
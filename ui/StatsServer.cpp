@@ -0,0 +1,70 @@
+#include "StatsServer.h"
+#include "../core/Stats.h"
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+StatsServer::StatsServer(QObject *parent) : QObject(parent)
+{
+}
+
+bool StatsServer::listenTcp(quint16 port)
+{
+	m_tcpServer = new QTcpServer(this);
+	connect(m_tcpServer, &QTcpServer::newConnection, this, [this]() {
+		while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+			connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+			connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { serve(socket); });
+		}
+	});
+	if (!m_tcpServer->listen(QHostAddress::LocalHost, port)) {
+		qWarning("StatsServer: cannot listen on 127.0.0.1:%d: %s", port,
+		         qPrintable(m_tcpServer->errorString()));
+		return false;
+	}
+	return true;
+}
+
+bool StatsServer::listenLocal(const QString &name)
+{
+	m_localServer = new QLocalServer(this);
+	// A socket file left by a crashed session would make listen() fail.
+	QLocalServer::removeServer(name);
+	connect(m_localServer, &QLocalServer::newConnection, this, [this]() {
+		while (QLocalSocket *socket = m_localServer->nextPendingConnection()) {
+			connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+			connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { serve(socket); });
+		}
+	});
+	if (!m_localServer->listen(name)) {
+		qWarning("StatsServer: cannot listen on %s: %s", qPrintable(name),
+		         qPrintable(m_localServer->errorString()));
+		return false;
+	}
+	return true;
+}
+
+void StatsServer::serve(QIODevice *socket)
+{
+	const bool http = socket->peek(4) == "GET ";
+	socket->readAll();
+	// Answered once; later data on the same connection is ignored.
+	socket->disconnect(this);
+
+	const QByteArray json = QByteArray::fromStdString(Stats::snapshot().toJson());
+	if (http) {
+		socket->write("HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: ");
+		socket->write(QByteArray::number(json.size()));
+		socket->write("\r\nConnection: close\r\n\r\n");
+	}
+	socket->write(json);
+
+	if (auto *tcp = qobject_cast<QTcpSocket *>(socket)) {
+		tcp->disconnectFromHost();
+	}
+	else if (auto *local = qobject_cast<QLocalSocket *>(socket)) {
+		local->disconnectFromServer();
+	}
+}
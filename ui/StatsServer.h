@@ -0,0 +1,31 @@
+#ifndef STATS_SERVER
+#define STATS_SERVER
+
+#include <QObject>
+#include <QString>
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+
+// Serves Stats::snapshot() as JSON to local monitoring. A client connects,
+// sends anything (an HTTP GET gets an HTTP response, so curl works) and
+// receives the JSON, after which the connection is closed. Runs on the thread
+// that owns it, through its event loop.
+class StatsServer : public QObject {
+public:
+	explicit StatsServer(QObject *parent = nullptr);
+
+	// Listens on 127.0.0.1 only.
+	bool listenTcp(quint16 port);
+	// A Unix domain socket (a named pipe on Windows), e.g. "sge-stats".
+	bool listenLocal(const QString &name);
+
+private:
+	void serve(QIODevice *socket);
+
+	QTcpServer *m_tcpServer = nullptr;
+	QLocalServer *m_localServer = nullptr;
+};
+
+#endif // STATS_SERVER